@@ -401,6 +401,10 @@ if has("syntax")
   call append("$", "synmaxcol\tmaximum column to look for syntax items")
   call append("$", "\t(local to buffer)")
   call <SID>OptionL("smc")
+  if has("persistent_undo")
+    call append("$", "syntaxcache\tkeep syntax states in a file next to the undo file")
+    call <SID>BinOptionG("syc", &syc)
+  endif
 endif
 call append("$", "highlight\twhich highlighting to use for various occasions")
 call <SID>OptionG("hl", &hl)
@@ -1023,6 +1027,8 @@ call append("$", "maxmem\tmaximum amount of memory in Kbyte used for one buffer"
 call append("$", " \tset mm=" . &mm)
 call append("$", "maxmemtot\tmaximum amount of memory in Kbyte used for all buffers")
 call append("$", " \tset mmt=" . &mmt)
+call append("$", "memcompress\tcompress text that does not fit in 'maxmem' or 'maxmemtot'")
+call <SID>BinOptionG("mcp", &mcp)
 
 
 call <SID>Header("command line editing")
@@ -609,6 +609,9 @@ buf_freeall(buf, flags)
 #ifdef FEAT_DIFF
     diff_buf_delete(buf);	    /* Can't use 'diff' for unloaded buffer. */
 #endif
+#if defined(FEAT_SYN_HL) && defined(FEAT_PERSISTENT_UNDO)
+    syn_cache_write(buf);	    /* keep the syntax states for next time */
+#endif
 #ifdef FEAT_SYN_HL
     /* Remove any ownsyntax, unless exiting. */
     if (firstwin != NULL && curwin->w_buffer == buf)
@@ -637,6 +640,9 @@ buf_freeall(buf, flags)
 #endif
     ml_close(buf, TRUE);	    /* close and delete the memline/memfile */
     buf->b_ml.ml_line_count = 0;    /* no lines in buffer */
+#ifdef FEAT_PERSISTENT_UNDO
+    buf->b_u_hash_valid = FALSE;    /* hash of the text is invalid */
+#endif
     if ((flags & BFA_KEEP_UNDO) == 0)
     {
 	u_blockfree(buf);	    /* free the memory allocated for undo */
@@ -21,6 +21,10 @@ static int win_nolbr_chartabsize __ARGS((win_T *wp, char_u *s, colnr_T col, int
 #endif
 
 static unsigned nr2hex __ARGS((unsigned c));
+static int vcol_simple __ARGS((win_T *wp));
+static int vcol_marks_valid __ARGS((win_T *wp, linenr_T lnum));
+static colnr_T vcol_mark_find __ARGS((win_T *wp, linenr_T lnum, char_u *line, colnr_T col, colnr_T vcol, char_u **ptrp, colnr_T *vcolp));
+static colnr_T vcol_mark_add __ARGS((win_T *wp, linenr_T lnum, colnr_T col, colnr_T vcol));
 
 static int    chartab_initialized = FALSE;
 
@@ -1296,6 +1300,196 @@ in_win_border(wp, vcol)
 }
 #endif /* FEAT_MBYTE */
 
+/*
+ * Return TRUE when the size of a character in window "wp" only depends on
+ * the virtual column where it starts, thus when 'list', 'linebreak',
+ * 'showbreak' and 'breakindent' are not set.  'list' is OK when tabs take
+ * their normal size.
+ */
+    static int
+vcol_simple(wp)
+    win_T	*wp;
+{
+    return (!wp->w_p_list || lcs_tab1 != NUL)
+#ifdef FEAT_LINEBREAK
+	    && !wp->w_p_lbr && *p_sbr == NUL && !wp->w_p_bri
+#endif
+	    ;
+}
+
+/*
+ * Return TRUE when w_vcol_marks of window "wp" are valid for line "lnum".
+ */
+    static int
+vcol_marks_valid(wp, lnum)
+    win_T	*wp;
+    linenr_T	lnum;
+{
+    return wp->w_vcol_lnum == lnum
+	    && wp->w_vcol_fnum == wp->w_buffer->b_fnum
+	    && wp->w_vcol_changedtick == wp->w_buffer->b_changedtick
+	    && wp->w_vcol_tick == linecache_tick
+	    && wp->w_vcol_width == W_WIDTH(wp) - win_col_off(wp)
+	    && wp->w_vcol_off2 == win_col_off2(wp);
+}
+
+/*
+ * Find the last remembered position in line "lnum" of window "wp" at or
+ * before byte index "col" and virtual column "vcol".  "line" is the text of
+ * the line.  When found set "*ptrp" and "*vcolp", otherwise they are not
+ * changed.
+ * Returns the byte index from where the next position is to be remembered,
+ * MAXCOL when there are further positions already.
+ */
+    static colnr_T
+vcol_mark_find(wp, lnum, line, col, vcol, ptrp, vcolp)
+    win_T	*wp;
+    linenr_T	lnum;
+    char_u	*line;
+    colnr_T	col;
+    colnr_T	vcol;
+    char_u	**ptrp;
+    colnr_T	*vcolp;
+{
+    vcolmark_T	*vm = (vcolmark_T *)wp->w_vcol_marks.ga_data;
+    int		lo = 0;
+    int		hi;
+    int		mid;
+
+    if (!vcol_marks_valid(wp, lnum))
+	return VCOL_MARK_BYTES;
+
+    /* Binary search for the first entry after "col" or "vcol". */
+    hi = wp->w_vcol_marks.ga_len;
+    while (lo < hi)
+    {
+	mid = (lo + hi) / 2;
+	if (vm[mid].vm_col <= col && vm[mid].vm_vcol <= vcol)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    if (lo > 0)
+    {
+	*ptrp = line + vm[lo - 1].vm_col;
+	*vcolp = vm[lo - 1].vm_vcol;
+    }
+    if (lo < wp->w_vcol_marks.ga_len || wp->w_vcol_complete
+			     || lo + 1 > MAXCOL / VCOL_MARK_BYTES)
+	return MAXCOL;
+    return (lo + 1) * VCOL_MARK_BYTES;
+}
+
+/*
+ * Remember that the character at byte index "col" in line "lnum" of window
+ * "wp" starts at virtual column "vcol".  Discards positions remembered for
+ * another line or an older text.
+ * Returns the byte index from where the next position is to be remembered,
+ * MAXCOL when out of memory.
+ */
+    static colnr_T
+vcol_mark_add(wp, lnum, col, vcol)
+    win_T	*wp;
+    linenr_T	lnum;
+    colnr_T	col;
+    colnr_T	vcol;
+{
+    garray_T	*gap = &wp->w_vcol_marks;
+    vcolmark_T	*vm;
+
+    if (!vcol_marks_valid(wp, lnum))
+    {
+	wp->w_vcol_lnum = lnum;
+	wp->w_vcol_fnum = wp->w_buffer->b_fnum;
+	wp->w_vcol_changedtick = wp->w_buffer->b_changedtick;
+	wp->w_vcol_tick = linecache_tick;
+	wp->w_vcol_width = W_WIDTH(wp) - win_col_off(wp);
+	wp->w_vcol_off2 = win_col_off2(wp);
+	wp->w_vcol_complete = FALSE;
+	gap->ga_len = 0;
+    }
+    if (ga_grow(gap, 1) == FAIL)
+	return MAXCOL;
+    vm = (vcolmark_T *)gap->ga_data + gap->ga_len;
+    vm->vm_col = col;
+    vm->vm_vcol = vcol;
+    ++gap->ga_len;
+    if (gap->ga_len + 1 > MAXCOL / VCOL_MARK_BYTES)
+	return MAXCOL;
+    return (gap->ga_len + 1) * VCOL_MARK_BYTES;
+}
+
+/*
+ * Find where to start counting virtual columns in line "lnum" of window "wp"
+ * to find virtual column "wcol", using the positions remembered by
+ * getvcol().  "line" is the text of the line.
+ * Returns the byte index of a character at or before "wcol" and sets
+ * "*vcolp" to its virtual column.  Returns zero when there is no such
+ * position, "*vcolp" is not changed then.
+ */
+    colnr_T
+getvcol_start(wp, lnum, line, wcol, vcolp)
+    win_T	*wp;
+    linenr_T	lnum;
+    char_u	*line;
+    colnr_T	wcol;
+    colnr_T	*vcolp;
+{
+    char_u	*ptr = line;
+    pos_T	pos;
+
+    if (wcol < VCOL_MARK_BYTES || !vcol_simple(wp))
+	return 0;
+
+    /* Go over the whole line once to remember positions in it. */
+    if (!vcol_marks_valid(wp, lnum) || !wp->w_vcol_complete)
+    {
+	pos.lnum = lnum;
+	pos.col = MAXCOL;
+#ifdef FEAT_VIRTUALEDIT
+	pos.coladd = 0;
+#endif
+	getvcol(wp, &pos, NULL, NULL, NULL);
+    }
+    (void)vcol_mark_find(wp, lnum, line, MAXCOL, wcol, &ptr, vcolp);
+    return (colnr_T)(ptr - line);
+}
+
+/*
+ * Called when lines "lnum" to "lnume" (exclusive) changed, starting at byte
+ * "col", and "xtra" lines were added: adjust w_vcol_marks of window "wp".
+ * The positions before "col" are still valid.
+ */
+    void
+getvcol_changed(wp, lnum, col, lnume, xtra)
+    win_T	*wp;
+    linenr_T	lnum;
+    colnr_T	col;
+    linenr_T	lnume;
+    long	xtra;
+{
+    garray_T	*gap = &wp->w_vcol_marks;
+
+    /* Only when valid before this change, b_changedtick was just
+     * incremented. */
+    if (wp->w_vcol_lnum == 0
+	    || wp->w_vcol_fnum != wp->w_buffer->b_fnum
+	    || wp->w_vcol_changedtick != wp->w_buffer->b_changedtick - 1)
+	return;
+    if (wp->w_vcol_lnum >= lnume)
+	wp->w_vcol_lnum += xtra;
+    else if (wp->w_vcol_lnum == lnum)
+    {
+	while (gap->ga_len > 0 && ((vcolmark_T *)gap->ga_data)
+					       [gap->ga_len - 1].vm_col >= col)
+	    --gap->ga_len;
+	wp->w_vcol_complete = FALSE;
+    }
+    else if (wp->w_vcol_lnum > lnum)
+	return;
+    wp->w_vcol_changedtick = wp->w_buffer->b_changedtick;
+}
+
 /*
  * Get virtual column number of pos.
  *  start: on the first position of this character (TAB, ctrl)
@@ -1334,12 +1528,15 @@ getvcol(wp, pos, start, cursor, end)
      * use a simple loop.
      * Also use this when 'list' is set but tabs take their normal size.
      */
-    if ((!wp->w_p_list || lcs_tab1 != NUL)
-#ifdef FEAT_LINEBREAK
-	    && !wp->w_p_lbr && *p_sbr == NUL && !wp->w_p_bri
-#endif
-       )
+    if (vcol_simple(wp))
     {
+	colnr_T	mark_col = MAXCOL;  /* where to remember the next position */
+
+	/* In a long line start at a remembered position, and remember
+	 * positions while going over the line. */
+	if (posptr == NULL || pos->col >= VCOL_MARK_BYTES)
+	    mark_col = vcol_mark_find(wp, pos->lnum, line, pos->col, MAXCOL,
+								 &ptr, &vcol);
 #ifndef FEAT_MBYTE
 	head = 0;
 #endif
@@ -1353,8 +1550,13 @@ getvcol(wp, pos, start, cursor, end)
 	    if (c == NUL)
 	    {
 		incr = 1;	/* NUL at end of line only takes one column */
+		if (mark_col != MAXCOL && vcol_marks_valid(wp, pos->lnum))
+		    wp->w_vcol_complete = TRUE;
 		break;
 	    }
+	    if ((colnr_T)(ptr - line) >= mark_col)
+		mark_col = vcol_mark_add(wp, pos->lnum, (colnr_T)(ptr - line),
+									 vcol);
 	    /* A tab gets expanded, depending on the current column */
 	    if (c == TAB)
 		incr = ts - (vcol % ts);
@@ -4594,7 +4594,10 @@ do_sub(eap)
 #endif
 		); ++lnum)
     {
-	nmatch = vim_regexec_multi(&regmatch, curwin, curbuf, lnum,
+	if (!vim_regline_may_match(&regmatch, curbuf, lnum))
+	    nmatch = 0;		/* quickly skip lines that can't match */
+	else
+	    nmatch = vim_regexec_multi(&regmatch, curwin, curbuf, lnum,
 							    (colnr_T)0, NULL);
 	if (nmatch)
 	{
@@ -5484,7 +5487,8 @@ ex_global(eap)
     for (lnum = eap->line1; lnum <= eap->line2 && !got_int; ++lnum)
     {
 	/* a match on this line? */
-	match = vim_regexec_multi(&regmatch, curwin, curbuf, lnum,
+	match = vim_regline_may_match(&regmatch, curbuf, lnum)
+		&& vim_regexec_multi(&regmatch, curwin, curbuf, lnum,
 							    (colnr_T)0, NULL);
 	if ((type == 'g' && match) || (type == 'v' && !match))
 	{
@@ -1128,6 +1128,9 @@ EX(CMD_redrawstatus,	"redrawstatus",	ex_redrawstatus,
 EX(CMD_registers,	"registers",	ex_display,
 			EXTRA|NOTRLCOM|TRLBAR|CMDWIN,
 			ADDR_LINES),
+EX(CMD_regexpstats,	"regexpstats",	ex_regexpstats,
+			TRLBAR|CMDWIN,
+			ADDR_LINES),
 EX(CMD_resize,		"resize",	ex_resize,
 			RANGE|NOTADR|TRLBAR|WORD1,
 			ADDR_LINES),
@@ -1356,11 +1359,14 @@ EX(CMD_sview,		"sview",	ex_splitview,
 EX(CMD_swapname,	"swapname",	ex_swapname,
 			TRLBAR|CMDWIN,
 			ADDR_LINES),
+EX(CMD_swapstats,	"swapstats",	ex_swapstats,
+			TRLBAR|CMDWIN,
+			ADDR_LINES),
 EX(CMD_syntax,		"syntax",	ex_syntax,
 			EXTRA|NOTRLCOM|CMDWIN,
 			ADDR_LINES),
 EX(CMD_syntime,		"syntime",	ex_syntime,
-			NEEDARG|WORD1|TRLBAR|CMDWIN,
+			NEEDARG|EXTRA|TRLBAR|CMDWIN,
 			ADDR_LINES),
 EX(CMD_syncbind,	"syncbind",	ex_syncbind,
 			TRLBAR,
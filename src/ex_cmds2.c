@@ -4305,6 +4305,10 @@ ex_language(eap)
 	    /* Reset $LC_ALL, otherwise it would overrule everything. */
 	    vim_setenv((char_u *)"LC_ALL", (char_u *)"");
 
+	    /* Compiled patterns depend on the character classes. */
+	    if (what == LC_ALL || what == LC_CTYPE)
+		regcache_clear();
+
 	    if (what != LC_TIME)
 	    {
 		/* Tell gettext() what to translate to.  It apparently doesn't
@@ -21,8 +21,20 @@
 # include <utime.h>		/* for struct utimbuf */
 #endif
 
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+# include <sys/mman.h>
+# define USE_READ_MMAP
+# define READ_MMAP_MIN	0x100000L   /* only map files at least this big */
+# define READ_MMAP_CHUNK 0x100000L  /* bytes handled between breakchecks */
+#endif
+
 #define BUFSIZE		8192	/* size of normal write buffer */
 #define SMBUFSIZE	256	/* size of emergency write buffer */
+#if VIM_SIZEOF_INT >= 4
+# define WRITEBUFSIZE	65536	/* size of write buffer for buf_write() */
+#else
+# define WRITEBUFSIZE	BUFSIZE
+#endif
 
 /* Is there any system that doesn't have access()? */
 #define USE_MCH_ACCESS
@@ -43,6 +55,17 @@ static void check_marks_read __ARGS((void));
 #ifdef FEAT_CRYPT
 static char_u *check_for_cryptkey __ARGS((char_u *cryptkey, char_u *ptr, long *sizep, off_t *filesizep, int newfile, char_u *fname, int *did_ask));
 #endif
+#ifdef USE_READ_MMAP
+static char_u *readfile_mmap __ARGS((int fd, off_t offset, size_t *lenp));
+static int readfile_mmap_check __ARGS((int fd, size_t map_len, size_t *offp, long *restp, size_t *endp));
+#endif
+#ifdef FEAT_PERSISTENT_UNDO
+static void readfile_sha256_line __ARGS((context_sha256_T *ctx, char_u *line, colnr_T len));
+#endif
+static char_u *readfile_find_eol __ARGS((char_u *ptr, char_u *end, int eol, char_u **eolp, char_u **nlp));
+#ifdef FEAT_MBYTE
+static char_u *readfile_skip_ascii __ARGS((char_u *ptr, long len));
+#endif
 #ifdef UNIX
 static void set_file_time __ARGS((char_u *fname, time_t atime, time_t mtime));
 #endif
@@ -233,14 +256,22 @@ readfile(fname, sfname, from, lines_to_skip, lines_to_read, eap, flags)
     colnr_T	len;
     long	size = 0;
     char_u	*p;
+    char_u	*eol_ptr;		/* next end-of-line in "buffer" */
+    char_u	*nl_ptr;		/* next NL in "buffer" for Mac */
     off_t	filesize = 0;
     int		skip_read = FALSE;
+#ifdef USE_READ_MMAP
+    size_t	map_len = 0;		/* size of mapped file or zero */
+    size_t	map_off = 0;		/* offset of next text in mapping */
+    size_t	map_end = 0;		/* end of usable text in mapping */
+#endif
 #ifdef FEAT_CRYPT
     char_u	*cryptkey = NULL;
     int		did_ask_for_key = FALSE;
 #endif
 #ifdef FEAT_PERSISTENT_UNDO
     context_sha256_T sha_ctx;
+    int		hash_text = FALSE;	/* compute hash of the text */
     int		read_undo_file = FALSE;
 #endif
     int		split = 0;		/* number of split lines */
@@ -943,6 +974,16 @@ retry:
 	while (lnum > from)
 	    ml_delete(lnum--, FALSE);
 	file_rewind = FALSE;
+#ifdef USE_READ_MMAP
+	if (map_len > 0)
+	{
+	    /* The text may need to be converted now, start reading the file
+	     * in chunks again. */
+	    munmap(buffer, map_len);
+	    buffer = NULL;
+	    map_len = 0;
+	}
+#endif
 #ifdef FEAT_MBYTE
 	if (set_options)
 	{
@@ -1146,13 +1187,19 @@ retry:
 	conv_restlen = 0;
 #endif
 #ifdef FEAT_PERSISTENT_UNDO
-	read_undo_file = (newfile && (flags & READ_KEEP_UNDO) == 0
+	/* The hash is also used for the syntax cache. */
+	hash_text = (newfile && (flags & READ_KEEP_UNDO) == 0
 				  && curbuf->b_ffname != NULL
-				  && curbuf->b_p_udf
+				  && (curbuf->b_p_udf
+# ifdef FEAT_SYN_HL
+				      || p_syc
+# endif
+				     )
 				  && !filtering
 				  && !read_stdin
 				  && !read_buffer);
-	if (read_undo_file)
+	read_undo_file = hash_text && curbuf->b_p_udf;
+	if (hash_text)
 	    sha256_start(&sha_ctx);
 #endif
 #ifdef FEAT_CRYPT
@@ -1166,6 +1213,10 @@ retry:
 #endif
     }
 
+    /* Lines are appended one after another, let ml_append() put them in
+     * new blocks instead of in front of the text that follows. */
+    curbuf->b_ml.ml_flags |= ML_APPEND_BULK;
+
     while (!error && !got_int)
     {
 	/*
@@ -1196,24 +1247,52 @@ retry:
 		size = 0x7ff0L - linerest;	    /* limit buffer to 32K */
 #endif
 
-		for ( ; size >= 10; size = (long)((long_u)size >> 1))
+#ifdef USE_READ_MMAP
+		if (map_len > 0
+			&& !readfile_mmap_check(fd, map_len, &map_off, &linerest,
+								   &map_end))
 		{
-		    if ((new_buffer = lalloc((long_u)(size + linerest + 1),
-							      FALSE)) != NULL)
-			break;
+		    /* Continue in the mapped file, the remaining text of the
+		     * previous part is just before the next part. */
+		    size = READ_MMAP_CHUNK;
+		    ptr = buffer + map_off;
+		    line_start = ptr - linerest;
+# ifdef FEAT_MBYTE
+		    line_start -= conv_restlen;
+# endif
 		}
-		if (new_buffer == NULL)
+		else
+#endif
 		{
-		    do_outofmem_msg((long_u)(size * 2 + linerest + 1));
-		    error = TRUE;
-		    break;
+		    for ( ; size >= 10; size = (long)((long_u)size >> 1))
+		    {
+			if ((new_buffer = lalloc((long_u)(size + linerest + 1),
+							      FALSE)) != NULL)
+			    break;
+		    }
+		    if (new_buffer == NULL)
+		    {
+			do_outofmem_msg((long_u)(size * 2 + linerest + 1));
+			error = TRUE;
+			break;
+		    }
+		    if (linerest)   /* copy characters from the previous buffer */
+			mch_memmove(new_buffer, ptr - linerest,
+							   (size_t)linerest);
+#ifdef USE_READ_MMAP
+		    if (map_len > 0)
+		    {
+			/* The mapped file grew, read the rest. */
+			munmap(buffer, map_len);
+			map_len = 0;
+		    }
+		    else
+#endif
+			vim_free(buffer);
+		    buffer = new_buffer;
+		    ptr = buffer + linerest;
+		    line_start = buffer;
 		}
-		if (linerest)	/* copy characters from the previous buffer */
-		    mch_memmove(new_buffer, ptr - linerest, (size_t)linerest);
-		vim_free(buffer);
-		buffer = new_buffer;
-		ptr = buffer + linerest;
-		line_start = buffer;
 
 #ifdef FEAT_MBYTE
 		/* May need room to translate into.
@@ -1251,7 +1330,11 @@ retry:
 #endif
 
 #ifdef FEAT_MBYTE
-		if (conv_restlen > 0)
+		if (conv_restlen > 0
+# ifdef USE_READ_MMAP
+			&& map_len == 0	    /* mapped: already before "ptr" */
+# endif
+			)
 		{
 		    /* Insert unconverted bytes from previous line. */
 		    mch_memmove(ptr, conv_rest, conv_restlen);
@@ -1320,6 +1403,17 @@ retry:
 			}
 		    }
 		}
+#ifdef USE_READ_MMAP
+		else if (map_len > 0)
+		{
+		    /*
+		     * Use the next part of the mapped file.
+		     */
+		    if ((size_t)size > map_end - map_off)
+			size = (long)(map_end - map_off);
+		    map_off += size;
+		}
+#endif
 		else
 		{
 		    /*
@@ -1538,6 +1632,35 @@ retry:
 	    if (size <= 0)
 		break;
 
+#ifdef USE_READ_MMAP
+	    /*
+	     * When the text does not need to be converted or decrypted, map a
+	     * large file into memory and continue with the text there, it is
+	     * then split into lines without copying it into a buffer first.
+	     * The bytes just read are still unchanged, use them from the
+	     * mapping.
+	     */
+	    if (map_len == 0 && linerest == 0 && !read_stdin && !read_buffer
+# ifdef FEAT_MBYTE
+		    && fio_flags == 0
+#  ifdef USE_ICONV
+		    && iconv_fd == (iconv_t)-1
+#  endif
+# endif
+# ifdef FEAT_CRYPT
+		    && curbuf->b_cryptstate == NULL
+# endif
+		    && (p = readfile_mmap(fd, filesize + size, &map_len)) != NULL)
+	    {
+		vim_free(buffer);
+		buffer = p;
+		ptr = buffer + filesize;
+		line_start = ptr;
+		map_off = (size_t)(filesize + size);
+		map_end = map_len;
+	    }
+#endif
+
 #ifdef FEAT_MBYTE
 
 # ifdef USE_ICONV
@@ -2013,6 +2136,12 @@ retry:
 
 		    if (todo <= 0)
 			break;
+		    if (*p < 0x80)
+		    {
+			/* skip over ASCII bytes a word at a time */
+			p = readfile_skip_ascii(p, (long)todo) - 1;
+			continue;
+		    }
 		    if (*p >= 0x80)
 		    {
 			/* A length of 1 means it's an illegal byte.  Accept
@@ -2163,14 +2292,23 @@ rewind_retry:
 	 * This loop is executed once for every character read.
 	 * Keep it fast!
 	 */
+	eol_ptr = NULL;
+	nl_ptr = NULL;
 	if (fileformat == EOL_MAC)
 	{
 	    --ptr;
 	    while (++ptr, --size >= 0)
 	    {
-		/* catch most common case first */
+		/* catch most common case first: skip to the next NUL, CR or
+		 * NL */
 		if ((c = *ptr) != NUL && c != CAR && c != NL)
+		{
+		    p = readfile_find_eol(ptr, ptr + size + 1, CAR,
+						       &eol_ptr, &nl_ptr) - 1;
+		    size -= (long)(p - ptr);
+		    ptr = p;
 		    continue;
+		}
 		if (c == NUL)
 		    *ptr = NL;	/* NULs are replaced by newlines! */
 		else if (c == NL)
@@ -2179,7 +2317,8 @@ rewind_retry:
 		{
 		    if (skip_count == 0)
 		    {
-			*ptr = NUL;	    /* end of line */
+			/* end of line, ml_append() replaces the CR with a
+			 * NUL */
 			len = (colnr_T) (ptr - line_start + 1);
 			if (ml_append(lnum, line_start, len, newfile) == FAIL)
 			{
@@ -2187,8 +2326,8 @@ rewind_retry:
 			    break;
 			}
 #ifdef FEAT_PERSISTENT_UNDO
-			if (read_undo_file)
-			    sha256_update(&sha_ctx, line_start, len);
+			if (hash_text)
+			    readfile_sha256_line(&sha_ctx, line_start, len);
 #endif
 			++lnum;
 			if (--read_count == 0)
@@ -2209,23 +2348,28 @@ rewind_retry:
 	    --ptr;
 	    while (++ptr, --size >= 0)
 	    {
-		if ((c = *ptr) != NUL && c != NL)  /* catch most common case */
+		/* catch most common case first: skip to the next NUL or NL */
+		if ((c = *ptr) != NUL && c != NL)
+		{
+		    p = readfile_find_eol(ptr, ptr + size + 1, NL,
+						       &eol_ptr, &nl_ptr) - 1;
+		    size -= (long)(p - ptr);
+		    ptr = p;
 		    continue;
+		}
 		if (c == NUL)
 		    *ptr = NL;	/* NULs are replaced by newlines! */
 		else
 		{
 		    if (skip_count == 0)
 		    {
-			*ptr = NUL;		/* end of line */
+			/* end of line, ml_append() replaces the NL with a
+			 * NUL */
 			len = (colnr_T)(ptr - line_start + 1);
 			if (fileformat == EOL_DOS)
 			{
-			    if (ptr[-1] == CAR)	/* remove CR */
-			    {
-				ptr[-1] = NUL;
-				--len;
-			    }
+			    if (ptr > line_start && ptr[-1] == CAR)
+				--len;		/* remove CR */
 			    /*
 			     * Reading in Dos format, but no CR-LF found!
 			     * When 'fileformats' includes "unix", delete all
@@ -2255,8 +2399,8 @@ rewind_retry:
 			    break;
 			}
 #ifdef FEAT_PERSISTENT_UNDO
-			if (read_undo_file)
-			    sha256_update(&sha_ctx, line_start, len);
+			if (hash_text)
+			    readfile_sha256_line(&sha_ctx, line_start, len);
 #endif
 			++lnum;
 			if (--read_count == 0)
@@ -2297,19 +2441,21 @@ failed:
 	/* remember for when writing */
 	if (set_options)
 	    curbuf->b_p_eol = FALSE;
-	*ptr = NUL;
+	/* ml_append() adds the NUL, "ptr" may be at the end of the mapped
+	 * file */
 	len = (colnr_T)(ptr - line_start + 1);
 	if (ml_append(lnum, line_start, len, newfile) == FAIL)
 	    error = TRUE;
 	else
 	{
 #ifdef FEAT_PERSISTENT_UNDO
-	    if (read_undo_file)
-		sha256_update(&sha_ctx, line_start, len);
+	    if (hash_text)
+		readfile_sha256_line(&sha_ctx, line_start, len);
 #endif
 	    read_no_eol_lnum = ++lnum;
 	}
     }
+    curbuf->b_ml.ml_flags &= ~ML_APPEND_BULK;
 
     if (set_options)
 	save_file_ff(curbuf);		/* remember the current file format */
@@ -2353,7 +2499,12 @@ failed:
 	    fcntl(fd, F_SETFD, fdflags | FD_CLOEXEC);
     }
 #endif
-    vim_free(buffer);
+#ifdef USE_READ_MMAP
+    if (map_len > 0)
+	munmap(buffer, map_len);
+    else
+#endif
+	vim_free(buffer);
 
 #ifdef HAVE_DUP
     if (read_stdin)
@@ -2637,14 +2788,17 @@ failed:
 
 #ifdef FEAT_PERSISTENT_UNDO
     /*
-     * When opening a new file locate undo info and read it.
+     * When opening a new file remember the hash of the text, locate undo info
+     * and read it.
      */
-    if (read_undo_file)
+    if (hash_text)
     {
 	char_u	hash[UNDO_HASH_SIZE];
 
 	sha256_finish(&sha_ctx, hash);
-	u_read_undo(NULL, hash, fname);
+	u_set_buf_hash(curbuf, hash);
+	if (read_undo_file)
+	    u_read_undo(NULL, hash, fname);
     }
 #endif
 
@@ -2928,6 +3082,171 @@ check_marks_read()
 }
 #endif
 
+#ifdef USE_READ_MMAP
+/*
+ * Map file "fd" into memory for readfile(), so that the text can be split
+ * into lines where it is.  Only done for a large regular file, when
+ * "offset" bytes have been read from it.
+ * Returns a pointer to the text and sets "*lenp" to its size.  Returns NULL
+ * when the file is not mapped.
+ * The size is the size of the file at this moment.  If the file changes
+ * while it is being read readfile_mmap_check() takes care of that.
+ */
+    static char_u *
+readfile_mmap(fd, offset, lenp)
+    int		fd;
+    off_t	offset;
+    size_t	*lenp;
+{
+    struct stat	st;
+    char_u	*p;
+
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)
+	    || st.st_size < READ_MMAP_MIN
+	    || (off_t)(size_t)st.st_size != st.st_size
+	    || lseek(fd, (off_t)0L, SEEK_CUR) != offset)
+	return NULL;
+
+    /* The mapping is private: only pages where readfile() replaces a NUL
+     * or an illegal byte are copied, the file itself is never changed. */
+    p = (char_u *)mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+						    MAP_PRIVATE, fd, (off_t)0);
+    if (p == (char_u *)MAP_FAILED)
+	return NULL;
+    *lenp = (size_t)st.st_size;
+    return p;
+}
+
+/*
+ * Check file "fd", mapped by readfile_mmap(), before using the text from
+ * offset "*offp", which follows "*restp" bytes of an unfinished line.  The
+ * mapping has the size "map_len" that the file had when it was mapped, but
+ * the file may have changed since then:
+ * - When it was truncated the pages after the new end can't be accessed,
+ *   that would cause a SIGBUS.  Reduce "*endp" to the new size, the text
+ *   stops there.  Also drop the part of the unfinished line that is gone.
+ *   The check is done for each part of READ_MMAP_CHUNK bytes, a file that
+ *   is truncated while a part is being split into lines may still cause a
+ *   SIGBUS.
+ * - When it grew and the whole mapping has been used return TRUE, the rest
+ *   of the file is to be read with read() from offset "map_len".
+ */
+    static int
+readfile_mmap_check(fd, map_len, offp, restp, endp)
+    int		fd;
+    size_t	map_len;
+    size_t	*offp;
+    long	*restp;
+    size_t	*endp;
+{
+    struct stat	st;
+    size_t	end;
+
+    if (fstat(fd, &st) < 0)
+	return FALSE;
+    end = (size_t)st.st_size;
+    if (end < *endp)
+    {
+	if (end < *offp)
+	{
+	    if (end < *offp - (size_t)*restp)
+		*restp = 0;
+	    else
+		*restp -= (long)(*offp - end);
+	    *offp = end;
+	}
+	*endp = end;
+    }
+    return *offp == map_len && end > map_len
+	    && lseek(fd, (off_t)map_len, SEEK_SET) == (off_t)map_len;
+}
+#endif
+
+#ifdef FEAT_PERSISTENT_UNDO
+/*
+ * Add a line read by readfile() to the hash used for the undo file.  "len"
+ * includes the NUL, which is not in the text.
+ */
+    static void
+readfile_sha256_line(ctx, line, len)
+    context_sha256_T	*ctx;
+    char_u		*line;
+    colnr_T		len;
+{
+    sha256_update(ctx, line, (UINT32_T)(len - 1));
+    sha256_update(ctx, (char_u *)"", 1);
+}
+#endif
+
+/*
+ * Find the end of a line for readfile(): Return a pointer to the first "eol"
+ * character or NUL from "ptr" up to "end", "end" when there is none.  When
+ * "eol" is CAR a NL is also found.
+ * Uses memchr(), which is much faster than checking each byte.
+ * "*eolp" and "*nlp" remember where the next "eol" and NL are, so that
+ * after a NUL the text after it is not searched again.  They must be NULL
+ * for new text.  Only looks for a NUL before the end of the line.
+ */
+    static char_u *
+readfile_find_eol(ptr, end, eol, eolp, nlp)
+    char_u	*ptr;
+    char_u	*end;
+    int		eol;
+    char_u	**eolp;
+    char_u	**nlp;
+{
+    char_u	*p;
+
+    if (*eolp == NULL || *eolp < ptr)
+    {
+	*eolp = memchr(ptr, eol, (size_t)(end - ptr));
+	if (*eolp == NULL)
+	    *eolp = end;
+    }
+    end = *eolp;
+    if (eol == CAR)
+    {
+	/* "*nlp" is not after "*eolp", when there is no NL before "*eolp"
+	 * it is equal to it. */
+	if (*nlp == NULL || *nlp < ptr)
+	{
+	    *nlp = memchr(ptr, NL, (size_t)(end - ptr));
+	    if (*nlp == NULL)
+		*nlp = end;
+	}
+	end = *nlp;
+    }
+    p = memchr(ptr, NUL, (size_t)(end - ptr));
+    return p == NULL ? end : p;
+}
+
+#ifdef FEAT_MBYTE
+/*
+ * Return a pointer to the first byte in "ptr[len]" that is not ASCII,
+ * "ptr + len" when there is none.  Checks a word at a time.
+ */
+    static char_u *
+readfile_skip_ascii(ptr, len)
+    char_u	*ptr;
+    long	len;
+{
+    char_u	*end = ptr + len;
+    long_u	mask = ((long_u)-1 / 0xff) * 0x80;  /* 0x80 in every byte */
+    long_u	word;
+
+    while (end - ptr >= (long)sizeof(long_u))
+    {
+	mch_memmove(&word, ptr, sizeof(long_u));
+	if (word & mask)
+	    break;
+	ptr += sizeof(long_u);
+    }
+    while (ptr < end && *ptr < 0x80)
+	++ptr;
+    return ptr;
+}
+#endif
+
 #if defined(FEAT_CRYPT) || defined(PROTO)
 /*
  * Check for magic number used for encryption.  Applies to the current buffer.
@@ -3109,7 +3428,10 @@ buf_write(buf, fname, sfname, start, end, eap, append, forceit,
     char_u	    *wfname = NULL;	/* name of file to write to */
     char_u	    *s;
     char_u	    *ptr;
+    char_u	    *p;
+    char_u	    *line_end;
     char_u	    c;
+    int		    n;
     int		    len;
     linenr_T	    lnum;
     long	    nchars;
@@ -3496,7 +3818,7 @@ buf_write(buf, fname, sfname, start, end, eap, append, forceit,
 		    (char_u *)"", 0);	/* show that we are busy */
     msg_scroll = FALSE;		    /* always overwrite the file message now */
 
-    buffer = alloc(BUFSIZE);
+    buffer = alloc(WRITEBUFSIZE);
     if (buffer == NULL)		    /* can't allocate big buffer, use small
 				     * one (to be able to write when out of
 				     * memory) */
@@ -3505,7 +3827,7 @@ buf_write(buf, fname, sfname, start, end, eap, append, forceit,
 	bufsize = SMBUFSIZE;
     }
     else
-	bufsize = BUFSIZE;
+	bufsize = WRITEBUFSIZE;
 
     /*
      * Get information about original file (if there is one).
@@ -4512,25 +4834,34 @@ restore_backup:
     len = 0;
     for (lnum = start; lnum <= end; ++lnum)
     {
-	/*
-	 * The next while loop is done once for each character written.
-	 * Keep it fast!
-	 */
-	ptr = ml_get_buf(buf, lnum, FALSE) - 1;
+	ptr = ml_get_buf(buf, lnum, FALSE);
+	line_end = ptr + STRLEN(ptr);
 #ifdef FEAT_PERSISTENT_UNDO
 	if (write_undo_file)
-	    sha256_update(&sha_ctx, ptr + 1, (UINT32_T)(STRLEN(ptr + 1) + 1));
+	    sha256_update(&sha_ctx, ptr, (UINT32_T)(line_end - ptr + 1));
 #endif
-	while ((c = *++ptr) != NUL)
-	{
-	    if (c == NL)
-		*s = NUL;		/* replace newlines with NULs */
-	    else if (c == CAR && fileformat == EOL_MAC)
-		*s = NL;		/* Mac: replace CRs with NLs */
-	    else
-		*s = c;
-	    ++s;
-	    if (++len != bufsize)
+	/*
+	 * The next while loop is done once for each time the buffer fills up.
+	 * The line is copied in one go and only the few characters that need
+	 * to be changed are looked up with memchr().  Keep it fast!
+	 */
+	while (ptr < line_end)
+	{
+	    n = (int)(line_end - ptr);
+	    if (n > bufsize - len)
+		n = bufsize - len;
+	    mch_memmove(s, ptr, (size_t)n);
+	    ptr += n;
+	    /* replace newlines with NULs */
+	    for (p = s; (p = memchr(p, NL, (size_t)(s + n - p))) != NULL; )
+		*p++ = NUL;
+	    /* Mac: replace CRs with NLs */
+	    if (fileformat == EOL_MAC)
+		for (p = s; (p = memchr(p, CAR, (size_t)(s + n - p))) != NULL; )
+		    *p++ = NL;
+	    s += n;
+	    len += n;
+	    if (len != bufsize)
 		continue;
 	    if (buf_write_bytes(&write_info) == FAIL)
 	    {
@@ -5065,6 +5396,7 @@ nofail:
 	char_u	    hash[UNDO_HASH_SIZE];
 
 	sha256_finish(&sha_ctx, hash);
+	u_set_buf_hash(buf, hash);
 	u_write_undo(NULL, FALSE, buf, hash);
     }
 #endif
@@ -1357,6 +1357,14 @@ EXTERN int	virtual_op INIT(= MAYBE);
 EXTERN disptick_T	display_tick INIT(= 0);
 #endif
 
+/* Number of buffer lines drawn by win_update(), for redrawstats() */
+EXTERN long	redraw_line_count INIT(= 0);
+
+/* Incremented when an option or highlighting changes in a way that makes the
+ * screen cells in w_linecache or the virtual columns in w_vcol_marks
+ * invalid. */
+EXTERN int	linecache_tick INIT(= 0);
+
 #ifdef FEAT_SPELL
 /* Line in which spell checking wasn't highlighted because it touched the
  * cursor position in Insert mode. */
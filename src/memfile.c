@@ -67,14 +67,23 @@ extern int dos2;			/* this is in os_amiga.c */
 
 #define MEMFILE_PAGE_SIZE 4096		/* default page size */
 
+/* number of bytes used for the data of block "hp" */
+#define MF_DATA_SIZE(mfp, hp) ((hp)->bh_csize != 0 ? (long_u)(hp)->bh_csize \
+		       : (long_u)(hp)->bh_page_count * (mfp)->mf_page_size)
+
 static long_u	total_mem_used = 0;	/* total memory used for memfiles */
 
-static void mf_ins_hash __ARGS((memfile_T *, bhdr_T *));
+static int mf_ins_hash __ARGS((memfile_T *, bhdr_T *));
 static void mf_rem_hash __ARGS((memfile_T *, bhdr_T *));
 static bhdr_T *mf_find_hash __ARGS((memfile_T *, blocknr_T));
 static void mf_ins_used __ARGS((memfile_T *, bhdr_T *));
 static void mf_rem_used __ARGS((memfile_T *, bhdr_T *));
 static bhdr_T *mf_release __ARGS((memfile_T *, int));
+static bhdr_T *mf_find_cold __ARGS((memfile_T *, int));
+static void mf_compress_block __ARGS((memfile_T *, bhdr_T *));
+static int mf_expand_block __ARGS((memfile_T *, bhdr_T *));
+static unsigned mf_compress __ARGS((char_u *src, unsigned len, char_u *dst, unsigned dlen));
+static int mf_decompress __ARGS((char_u *src, unsigned len, char_u *dst, unsigned dlen));
 static bhdr_T *mf_alloc_bhdr __ARGS((memfile_T *, int));
 static void mf_free_bhdr __ARGS((bhdr_T *));
 static void mf_ins_free __ARGS((memfile_T *, bhdr_T *));
@@ -88,7 +97,7 @@ static void mf_hash_init __ARGS((mf_hashtab_T *));
 static void mf_hash_free __ARGS((mf_hashtab_T *));
 static void mf_hash_free_all __ARGS((mf_hashtab_T *));
 static mf_hashitem_T *mf_hash_find __ARGS((mf_hashtab_T *, blocknr_T));
-static void mf_hash_add_item __ARGS((mf_hashtab_T *, mf_hashitem_T *));
+static int mf_hash_add_item __ARGS((mf_hashtab_T *, mf_hashitem_T *));
 static void mf_hash_rem_item __ARGS((mf_hashtab_T *, mf_hashitem_T *));
 static int mf_hash_grow __ARGS((mf_hashtab_T *));
 
@@ -158,6 +167,16 @@ mf_open(fname, flags)
     mfp->mf_used_last = NULL;
     mfp->mf_dirty = FALSE;
     mfp->mf_used_count = 0;
+    mfp->mf_stat_writes = 0;
+    mfp->mf_stat_syncs = 0;
+    mfp->mf_stat_flushes = 0;
+    mfp->mf_stat_postponed = 0;
+    mfp->mf_comp_count = 0;
+    mfp->mf_comp_size = 0;
+#ifdef FEAT_PROFILE
+    profile_zero(&mfp->mf_stat_total);
+    profile_zero(&mfp->mf_stat_slowest);
+#endif
     mf_hash_init(&mfp->mf_hash);
     mf_hash_init(&mfp->mf_trans);
     mfp->mf_page_size = MEMFILE_PAGE_SIZE;
@@ -258,7 +277,7 @@ mf_close(mfp, del_file)
 					    /* free entries in used list */
     for (hp = mfp->mf_used_first; hp != NULL; hp = nextp)
     {
-	total_mem_used -= hp->bh_page_count * mfp->mf_page_size;
+	total_mem_used -= MF_DATA_SIZE(mfp, hp);
 	nextp = hp->bh_next;
 	mf_free_bhdr(hp);
     }
@@ -405,8 +424,20 @@ mf_new(mfp, negative, page_count)
     hp->bh_flags = BH_LOCKED | BH_DIRTY;	/* new block is always dirty */
     mfp->mf_dirty = TRUE;
     hp->bh_page_count = page_count;
+    if (mf_ins_hash(mfp, hp) == FAIL)
+    {
+	/* Out of memory: like mf_free(), the block is in no list yet. */
+	vim_free(hp->bh_data);
+	if (hp->bh_bnum < 0)
+	{
+	    vim_free(hp);
+	    mfp->mf_neg_count--;
+	}
+	else
+	    mf_ins_free(mfp, hp);
+	return NULL;
+    }
     mf_ins_used(mfp, hp);
-    mf_ins_hash(mfp, hp);
 
     /*
      * Init the data to all zero, to avoid reading uninitialized data.
@@ -438,7 +469,7 @@ mf_get(mfp, nr, page_count)
      * see if it is in the cache
      */
     hp = mf_find_hash(mfp, nr);
-    if (hp == NULL)	/* not in the hash list */
+    if (hp == NULL)	/* not in the hashtable */
     {
 	if (nr < 0 || nr >= mfp->mf_infile_count)   /* can't be in the file */
 	    return NULL;
@@ -462,16 +493,27 @@ mf_get(mfp, nr, page_count)
 	    mf_free_bhdr(hp);
 	    return NULL;
 	}
+	if (mf_ins_hash(mfp, hp) == FAIL)
+	{
+	    mf_free_bhdr(hp);
+	    return NULL;
+	}
+	mf_ins_used(mfp, hp);	/* put in front of used list */
     }
-    else
+    else if (hp->bh_csize != 0)
     {
-	mf_rem_used(mfp, hp);	/* remove from list, insert in front below */
-	mf_rem_hash(mfp, hp);
+	if (mf_expand_block(mfp, hp) == FAIL)
+	    return NULL;
+	hp->bh_flags |= BH_REFERENCED | BH_LOCKED;
+	/* Without a file this compresses another block to make room. */
+	if (mfp->mf_fd < 0)
+	    (void)mf_release(mfp, page_count);
     }
+    else
+	/* Only remember that it was used, mf_release() will move it. */
+	hp->bh_flags |= BH_REFERENCED;
 
     hp->bh_flags |= BH_LOCKED;
-    mf_ins_used(mfp, hp);	/* put in front of used list */
-    mf_ins_hash(mfp, hp);	/* put in front of hash list */
 
     return hp;
 }
@@ -519,6 +561,12 @@ mf_free(mfp, hp)
     vim_free(hp->bh_data);	/* free the memory */
     mf_rem_hash(mfp, hp);	/* get *hp out of the hash list */
     mf_rem_used(mfp, hp);	/* get *hp out of the used list */
+    if (hp->bh_csize != 0)
+    {
+	--mfp->mf_comp_count;
+	mfp->mf_comp_size -= hp->bh_csize;
+	hp->bh_csize = 0;
+    }
     if (hp->bh_bnum < 0)
     {
 	vim_free(hp);		/* don't want negative numbers in free list */
@@ -563,6 +611,9 @@ mf_sync(mfp, flags)
     int		fd;
 #endif
     int		got_int_save = got_int;
+#ifdef FEAT_PROFILE
+    proftime_T	tm;
+#endif
 
     if (mfp->mf_fd < 0)	    /* there is no file, nothing to do */
     {
@@ -570,6 +621,11 @@ mf_sync(mfp, flags)
 	return FAIL;
     }
 
+    ++mfp->mf_stat_syncs;
+#ifdef FEAT_PROFILE
+    profile_start(&tm);
+#endif
+
     /* Only a CTRL-C while writing will break us here, not one typed
      * previously. */
     got_int = FALSE;
@@ -614,8 +670,22 @@ mf_sync(mfp, flags)
     if (hp == NULL || status == FAIL)
 	mfp->mf_dirty = FALSE;
 
+    /*
+     * When we stopped because a character was typed, don't flush now.  On a
+     * slow file system that can take a long time, while the user is waiting.
+     * The memfile is still dirty, the next call writes the remaining blocks
+     * and flushes.
+     */
+    if ((flags & (MFS_FLUSH | MFS_STOP)) == (MFS_FLUSH | MFS_STOP)
+						 && mfp->mf_dirty && !got_int)
+    {
+	++mfp->mf_stat_postponed;
+	flags &= ~MFS_FLUSH;
+    }
+
     if ((flags & MFS_FLUSH) && *p_sws != NUL)
     {
+	++mfp->mf_stat_flushes;
 #if defined(UNIX)
 # ifdef HAVE_FSYNC
 	/*
@@ -711,11 +781,34 @@ mf_sync(mfp, flags)
 #endif /* AMIGA */
     }
 
+#ifdef FEAT_PROFILE
+    profile_end(&tm);
+    profile_add(&mfp->mf_stat_total, &tm);
+    if (profile_cmp(&tm, &mfp->mf_stat_slowest) < 0)
+	mfp->mf_stat_slowest = tm;
+#endif
+
     got_int |= got_int_save;
 
     return status;
 }
 
+/*
+ * Return the number of blocks in memory that still need to be written.
+ */
+    int
+mf_dirty_count(mfp)
+    memfile_T	*mfp;
+{
+    bhdr_T	*hp;
+    int		count = 0;
+
+    for (hp = mfp->mf_used_first; hp != NULL; hp = hp->bh_next)
+	if (hp->bh_flags & BH_DIRTY)
+	    ++count;
+    return count;
+}
+
 /*
  * For all blocks in memory file *mfp that have a positive block number set
  * the dirty flag.  These are blocks that need to be written to a newly
@@ -734,18 +827,19 @@ mf_set_dirty(mfp)
 }
 
 /*
- * insert block *hp in front of hashlist of memfile *mfp
+ * insert block *hp in the hashtable of memfile *mfp
+ * Return FAIL when out of memory.
  */
-    static void
+    static int
 mf_ins_hash(mfp, hp)
     memfile_T	*mfp;
     bhdr_T	*hp;
 {
-    mf_hash_add_item(&mfp->mf_hash, (mf_hashitem_T *)hp);
+    return mf_hash_add_item(&mfp->mf_hash, (mf_hashitem_T *)hp);
 }
 
 /*
- * remove block *hp from hashlist of memfile list *mfp
+ * remove block *hp from the hashtable of memfile *mfp
  */
     static void
 mf_rem_hash(mfp, hp)
@@ -756,7 +850,7 @@ mf_rem_hash(mfp, hp)
 }
 
 /*
- * look in hash lists of memfile *mfp for block header with number 'nr'
+ * look in the hashtable of memfile *mfp for block header with number 'nr'
  */
     static bhdr_T *
 mf_find_hash(mfp, nr)
@@ -781,8 +875,9 @@ mf_ins_used(mfp, hp)
 	mfp->mf_used_last = hp;
     else
 	hp->bh_next->bh_prev = hp;
-    mfp->mf_used_count += hp->bh_page_count;
-    total_mem_used += hp->bh_page_count * mfp->mf_page_size;
+    if (hp->bh_csize == 0)
+	mfp->mf_used_count += hp->bh_page_count;
+    total_mem_used += MF_DATA_SIZE(mfp, hp);
 }
 
 /*
@@ -801,13 +896,14 @@ mf_rem_used(mfp, hp)
 	mfp->mf_used_first = hp->bh_next;
     else
 	hp->bh_prev->bh_next = hp->bh_next;
-    mfp->mf_used_count -= hp->bh_page_count;
-    total_mem_used -= hp->bh_page_count * mfp->mf_page_size;
+    if (hp->bh_csize == 0)
+	mfp->mf_used_count -= hp->bh_page_count;
+    total_mem_used -= MF_DATA_SIZE(mfp, hp);
 }
 
 /*
- * Release the least recently used block from the used list if the number
- * of used memory blocks gets to big.
+ * Release a block that was not used recently from the used list if the
+ * number of used memory blocks gets to big.
  *
  * Return the block header to the caller, including the memory block, so
  * it can be re-used. Make sure the page_count is right.
@@ -855,11 +951,18 @@ mf_release(mfp, page_count)
      *	total memory used is not up to 'maxmemtot'
      */
     if (mfp->mf_fd < 0 || !need_release)
+    {
+	/*
+	 * Without a file blocks cannot be released.  When 'memcompress' is
+	 * set compress a block that was not used recently instead.
+	 */
+	if (mfp->mf_fd < 0 && need_release && p_mcp
+				       && (hp = mf_find_cold(mfp, TRUE)) != NULL)
+	    mf_compress_block(mfp, hp);
 	return NULL;
+    }
 
-    for (hp = mfp->mf_used_last; hp != NULL; hp = hp->bh_prev)
-	if (!(hp->bh_flags & BH_LOCKED))
-	    break;
+    hp = mf_find_cold(mfp, FALSE);
     if (hp == NULL)	/* not a single one that can be released */
 	return NULL;
 
@@ -873,6 +976,15 @@ mf_release(mfp, page_count)
     mf_rem_used(mfp, hp);
     mf_rem_hash(mfp, hp);
 
+    /* A compressed block does not have the data in the normal form. */
+    if (hp->bh_csize != 0)
+    {
+	--mfp->mf_comp_count;
+	mfp->mf_comp_size -= hp->bh_csize;
+	hp->bh_csize = 0;
+	hp->bh_page_count = 0;	    /* force allocating bh_data below */
+    }
+
     /*
      * If a bhdr_T is returned, make sure that the page_count of bh_data is
      * right
@@ -890,6 +1002,270 @@ mf_release(mfp, page_count)
     return hp;
 }
 
+/*
+ * Find a block that was not used recently, to be released or compressed.
+ *
+ * This is the CLOCK algorithm: go over the used list starting with the
+ * oldest block.  A block that was used since it was last looked at gets a
+ * second chance: its BH_REFERENCED flag is reset and it is moved to the front
+ * of the list.  The first unlocked block without the flag is used.  This
+ * way mf_get() does not need to change the list for every block it finds.
+ * When "compress" is TRUE skip blocks that can't be compressed.
+ * Returns NULL when there is no such block.
+ */
+    static bhdr_T *
+mf_find_cold(mfp, compress)
+    memfile_T	*mfp;
+    int		compress;
+{
+    bhdr_T	*hp;
+    bhdr_T	*prev;
+
+    for (hp = mfp->mf_used_last; hp != NULL; hp = prev)
+    {
+	prev = hp->bh_prev;
+	/* Block zero is accessed directly by ml_setflags(), don't compress
+	 * it. */
+	if ((hp->bh_flags & BH_LOCKED)
+		       || (compress && (hp->bh_csize != 0 || hp->bh_bnum == 0)))
+	    continue;
+	/* Each block is moved at most once, when we get to it again the flag
+	 * has been reset.  The first block has nowhere to move to. */
+	if (!(hp->bh_flags & BH_REFERENCED) || prev == NULL)
+	    break;
+	hp->bh_flags &= ~BH_REFERENCED;
+	mf_rem_used(mfp, hp);
+	mf_ins_used(mfp, hp);
+    }
+    return hp;
+}
+
+/*
+ * Compress the data of block "hp", which must not be locked.
+ * Nothing happens when it doesn't get at least a quarter smaller, then the
+ * block is moved to the front of the used list, so that another block is
+ * tried next time.
+ */
+    static void
+mf_compress_block(mfp, hp)
+    memfile_T	*mfp;
+    bhdr_T	*hp;
+{
+    unsigned	size = hp->bh_page_count * mfp->mf_page_size;
+    unsigned	csize = 0;
+    char_u	*tmp;
+    char_u	*p = NULL;
+
+    tmp = alloc(size - size / 4);
+    if (tmp != NULL)
+    {
+	csize = mf_compress(hp->bh_data, size, tmp, size - size / 4);
+	if (csize > 0 && (p = alloc(csize)) != NULL)
+	    mch_memmove(p, tmp, (size_t)csize);
+	vim_free(tmp);
+    }
+
+    mf_rem_used(mfp, hp);
+    if (p != NULL)
+    {
+	vim_free(hp->bh_data);
+	hp->bh_data = p;
+	hp->bh_csize = csize;
+	++mfp->mf_comp_count;
+	mfp->mf_comp_size += csize;
+    }
+    mf_ins_used(mfp, hp);
+}
+
+/*
+ * Decompress the data of block "hp", if it was compressed.
+ * Return FAIL when out of memory.
+ */
+    static int
+mf_expand_block(mfp, hp)
+    memfile_T	*mfp;
+    bhdr_T	*hp;
+{
+    unsigned	size = hp->bh_page_count * mfp->mf_page_size;
+    char_u	*p;
+
+    if (hp->bh_csize == 0)
+	return OK;
+    p = alloc(size);
+    if (p == NULL)
+	return FAIL;
+    if (mf_decompress(hp->bh_data, hp->bh_csize, p, size) == FAIL)
+    {
+	/* can't happen, unless memory was corrupted */
+	EMSGN(_("E890: Block %ld is corrupted in memory"), hp->bh_bnum);
+	vim_free(p);
+	return FAIL;
+    }
+
+    /* keep the used list order, only update the amount of memory used */
+    total_mem_used += size - hp->bh_csize;
+    mfp->mf_used_count += hp->bh_page_count;
+    --mfp->mf_comp_count;
+    mfp->mf_comp_size -= hp->bh_csize;
+    vim_free(hp->bh_data);
+    hp->bh_data = p;
+    hp->bh_csize = 0;
+    return OK;
+}
+
+/*
+ * Compress "len" bytes at "src" into "dst", which has room for "dlen" bytes.
+ * This is a simple and fast LZ77 method, program text gets about a third
+ * smaller.  The output is a sequence of:
+ * - a byte below 32, followed by that number plus one literal bytes;
+ * - a match of three or more bytes found up to 8192 bytes back: the length
+ *   minus two in the top three bits, when it is 7 the rest of the length
+ *   follows in a separate byte, and the offset minus one in the low five
+ *   bits plus the next byte.
+ * Returns the number of bytes used, zero when it doesn't fit.
+ */
+#define MF_COMP_HASH_BITS   12
+#define MF_COMP_MAX_LIT	    32
+#define MF_COMP_MAX_OFF	    8192
+#define MF_COMP_MAX_MATCH   (2 + 7 + 255)
+
+    static unsigned
+mf_compress(src, len, dst, dlen)
+    char_u	*src;
+    unsigned	len;
+    char_u	*dst;
+    unsigned	dlen;
+{
+    unsigned	htab[1 << MF_COMP_HASH_BITS];
+    char_u	*ip = src;
+    char_u	*in_end = src + len;
+    char_u	*op = dst;
+    char_u	*out_end = dst + dlen;
+    char_u	*lit = src;	/* start of literals not written yet */
+    char_u	*ref;
+    unsigned	h;
+    unsigned	off;
+    unsigned	mlen;
+    unsigned	maxlen;
+    int		n;
+
+    vim_memset(htab, 0, sizeof(htab));
+    for (;;)
+    {
+	if (ip + 2 < in_end)
+	{
+	    h = ((unsigned)((ip[0] << 16) | (ip[1] << 8) | ip[2])
+			* 2654435761u) >> (32 - MF_COMP_HASH_BITS);
+	    h &= (1 << MF_COMP_HASH_BITS) - 1;
+	    ref = htab[h] == 0 ? NULL : src + htab[h] - 1;
+	    htab[h] = (unsigned)(ip - src) + 1;
+	    if (ref == NULL || ip - ref > MF_COMP_MAX_OFF
+		    || ref[0] != ip[0] || ref[1] != ip[1] || ref[2] != ip[2])
+	    {
+		++ip;
+		continue;
+	    }
+	}
+	else
+	{
+	    ip = in_end;
+	    ref = NULL;
+	}
+
+	/* write the literals before the match or the end */
+	while (lit < ip)
+	{
+	    n = (int)(ip - lit);
+	    if (n > MF_COMP_MAX_LIT)
+		n = MF_COMP_MAX_LIT;
+	    if (op + 1 + n > out_end)
+		return 0;
+	    *op++ = n - 1;
+	    mch_memmove(op, lit, (size_t)n);
+	    op += n;
+	    lit += n;
+	}
+	if (ref == NULL)
+	    break;
+
+	maxlen = (unsigned)(in_end - ip);
+	if (maxlen > MF_COMP_MAX_MATCH)
+	    maxlen = MF_COMP_MAX_MATCH;
+	for (mlen = 3; mlen < maxlen && ref[mlen] == ip[mlen]; ++mlen)
+	    ;
+	off = (unsigned)(ip - ref) - 1;
+	if (op + 3 > out_end)
+	    return 0;
+	if (mlen - 2 < 7)
+	    *op++ = ((mlen - 2) << 5) | (off >> 8);
+	else
+	{
+	    *op++ = (7 << 5) | (off >> 8);
+	    *op++ = mlen - 2 - 7;
+	}
+	*op++ = off & 0xff;
+	ip += mlen;
+	lit = ip;
+    }
+    return (unsigned)(op - dst);
+}
+
+/*
+ * Decompress "len" bytes at "src", compressed with mf_compress(), into "dst",
+ * which must be exactly "dlen" bytes.
+ * Returns FAIL when the data is invalid.
+ */
+    static int
+mf_decompress(src, len, dst, dlen)
+    char_u	*src;
+    unsigned	len;
+    char_u	*dst;
+    unsigned	dlen;
+{
+    char_u	*ip = src;
+    char_u	*in_end = src + len;
+    char_u	*op = dst;
+    char_u	*out_end = dst + dlen;
+    char_u	*ref;
+    unsigned	c;
+    unsigned	n;
+
+    while (ip < in_end)
+    {
+	c = *ip++;
+	if (c < MF_COMP_MAX_LIT)
+	{
+	    n = c + 1;
+	    if (ip + n > in_end || op + n > out_end)
+		return FAIL;
+	    mch_memmove(op, ip, (size_t)n);
+	    ip += n;
+	    op += n;
+	}
+	else
+	{
+	    n = c >> 5;
+	    if (n == 7)
+	    {
+		if (ip >= in_end)
+		    return FAIL;
+		n += *ip++;
+	    }
+	    n += 2;
+	    if (ip >= in_end)
+		return FAIL;
+	    c = (((c & 0x1f) << 8) | *ip++) + 1;
+	    if (c > (unsigned)(op - dst) || op + n > out_end)
+		return FAIL;
+	    ref = op - c;
+	    /* may overlap, copy one byte at a time */
+	    while (n-- > 0)
+		*op++ = *ref++;
+	}
+    }
+    return op == out_end ? OK : FAIL;
+}
+
 /*
  * release as many blocks as possible
  * Used in case of out of memory
@@ -956,6 +1332,7 @@ mf_alloc_bhdr(mfp, page_count)
 	    return NULL;
 	}
 	hp->bh_page_count = page_count;
+	hp->bh_csize = 0;
     }
     return hp;
 }
@@ -1058,6 +1435,9 @@ mf_write(mfp, hp)
     if (mfp->mf_fd < 0)	    /* there is no file, can't write */
 	return FAIL;
 
+    if (mf_expand_block(mfp, hp) == FAIL)
+	return FAIL;
+
     if (hp->bh_bnum < 0)	/* must assign file block number */
 	if (mf_trans_add(mfp, hp) == FAIL)
 	    return FAIL;
@@ -1087,6 +1467,8 @@ mf_write(mfp, hp)
 	    PERROR(_("E296: Seek error in swap file write"));
 	    return FAIL;
 	}
+	if (hp2 != NULL && mf_expand_block(mfp, hp2) == FAIL)
+	    return FAIL;
 	if (hp2 == NULL)	    /* freed block, fill with dummy data */
 	    page_count = 1;
 	else
@@ -1106,6 +1488,7 @@ mf_write(mfp, hp)
 	    return FAIL;
 	}
 	did_swapwrite_msg = FALSE;
+	++mfp->mf_stat_writes;
 	if (hp2 != NULL)		    /* written a non-dummy block */
 	    hp2->bh_flags &= ~BH_DIRTY;
 					    /* appended to the file */
@@ -1174,6 +1557,15 @@ mf_trans_add(mfp, hp)
     if ((np = (NR_TRANS *)alloc((unsigned)sizeof(NR_TRANS))) == NULL)
 	return FAIL;
 
+    /* Insert "np" into "mf_trans" hashtable with key "np->nt_old_bnum"
+     * before the block is changed, this can fail. */
+    np->nt_old_bnum = hp->bh_bnum;
+    if (mf_hash_add_item(&mfp->mf_trans, (mf_hashitem_T *)np) == FAIL)
+    {
+	vim_free(np);
+	return FAIL;
+    }
+
 /*
  * Get a new number for the block.
  * If the first item in the free list has sufficient pages, use its number
@@ -1205,15 +1597,12 @@ mf_trans_add(mfp, hp)
 	mfp->mf_blocknr_max += page_count;
     }
 
-    np->nt_old_bnum = hp->bh_bnum;	    /* adjust number */
-    np->nt_new_bnum = new_bnum;
+    np->nt_new_bnum = new_bnum;	    /* adjust number */
 
-    mf_rem_hash(mfp, hp);		    /* remove from old hash list */
+    /* Can't fail, removing the item leaves room for it. */
+    mf_rem_hash(mfp, hp);		    /* remove with the old number */
     hp->bh_bnum = new_bnum;
-    mf_ins_hash(mfp, hp);		    /* insert in new hash list */
-
-    /* Insert "np" into "mf_trans" hashtable with key "np->nt_old_bnum" */
-    mf_hash_add_item(&mfp->mf_trans, (mf_hashitem_T *)np);
+    (void)mf_ins_hash(mfp, hp);		    /* insert with the new number */
 
     return OK;
 }
@@ -1371,13 +1760,14 @@ mf_do_open(mfp, fname, flags)
  */
 
 /*
- * The number of buckets in the hashtable is increased by a factor of
- * MHT_GROWTH_FACTOR when the average number of items per bucket
- * exceeds 2 ^ MHT_LOG_LOAD_FACTOR.
+ * The number of slots in the hashtable is increased by a factor of
+ * MHT_GROWTH_FACTOR when more than half of them would be in use.  Keeping at
+ * least half of the slots empty keeps the probe sequences short.
  */
-#define MHT_LOG_LOAD_FACTOR 6
 #define MHT_GROWTH_FACTOR   2   /* must be a power of two */
 
+static void mf_hash_put_slot __ARGS((mf_hashslot_T *, long_u, mf_hashitem_T *));
+
 /*
  * Initialize an empty hash table.
  */
@@ -1386,7 +1776,7 @@ mf_hash_init(mht)
     mf_hashtab_T *mht;
 {
     vim_memset(mht, 0, sizeof(mf_hashtab_T));
-    mht->mht_buckets = mht->mht_small_buckets;
+    mht->mht_slots = mht->mht_small_slots;
     mht->mht_mask = MHT_INIT_SIZE - 1;
 }
 
@@ -1398,8 +1788,8 @@ mf_hash_init(mht)
 mf_hash_free(mht)
     mf_hashtab_T *mht;
 {
-    if (mht->mht_buckets != mht->mht_small_buckets)
-	vim_free(mht->mht_buckets);
+    if (mht->mht_slots != mht->mht_small_slots)
+	vim_free(mht->mht_slots);
 }
 
 /*
@@ -1410,15 +1800,9 @@ mf_hash_free_all(mht)
     mf_hashtab_T    *mht;
 {
     long_u	    idx;
-    mf_hashitem_T   *mhi;
-    mf_hashitem_T   *next;
 
     for (idx = 0; idx <= mht->mht_mask; idx++)
-	for (mhi = mht->mht_buckets[idx]; mhi != NULL; mhi = next)
-	{
-	    next = mhi->mhi_next;
-	    vim_free(mhi);
-	}
+	vim_free(mht->mht_slots[idx].mhs_item);
 
     mf_hash_free(mht);
 }
@@ -1432,140 +1816,133 @@ mf_hash_find(mht, key)
     mf_hashtab_T    *mht;
     blocknr_T	    key;
 {
-    mf_hashitem_T   *mhi;
+    mf_hashslot_T   *slot;
+    long_u	    idx;
+
+    /* Only the keys in the slots are compared, the items are not accessed
+     * until the right one is found. */
+    for (idx = (long_u)key & mht->mht_mask; ; idx = (idx + 1) & mht->mht_mask)
+    {
+	slot = &mht->mht_slots[idx];
+	if (slot->mhs_item == NULL)
+	    return NULL;
+	if (slot->mhs_key == key)
+	    return slot->mhs_item;
+    }
+}
 
-    mhi = mht->mht_buckets[key & mht->mht_mask];
-    while (mhi != NULL && mhi->mhi_key != key)
-	mhi = mhi->mhi_next;
+/*
+ * Put item "mhi" in the first empty slot starting at the slot for its key.
+ */
+    static void
+mf_hash_put_slot(slots, mask, mhi)
+    mf_hashslot_T   *slots;
+    long_u	    mask;
+    mf_hashitem_T   *mhi;
+{
+    long_u	    idx;
 
-    return mhi;
+    idx = (long_u)mhi->mhi_key & mask;
+    while (slots[idx].mhs_item != NULL)
+	idx = (idx + 1) & mask;
+    slots[idx].mhs_key = mhi->mhi_key;
+    slots[idx].mhs_item = mhi;
 }
 
 /*
  * Add item "mhi" to hashtable "mht".
  * "mhi" must not be NULL.
+ * Return FAIL when the table is full and can't grow.
  */
-    static void
+    static int
 mf_hash_add_item(mht, mhi)
     mf_hashtab_T    *mht;
     mf_hashitem_T   *mhi;
 {
-    long_u	    idx;
-
-    idx = mhi->mhi_key & mht->mht_mask;
-    mhi->mhi_next = mht->mht_buckets[idx];
-    mhi->mhi_prev = NULL;
-    if (mhi->mhi_next != NULL)
-	mhi->mhi_next->mhi_prev = mhi;
-    mht->mht_buckets[idx] = mhi;
-
-    mht->mht_count++;
-
     /*
-     * Grow hashtable when we have more thank 2^MHT_LOG_LOAD_FACTOR
-     * items per bucket on average
+     * Grow the hashtable before it gets too full.  If this fails the
+     * table is used as it is and growing is tried again for the next item.
+     * At least one slot must stay empty for mf_hash_find() to end, when
+     * growing failed that often the item is not added.
      */
-    if (mht->mht_fixed == 0
-	&& (mht->mht_count >> MHT_LOG_LOAD_FACTOR) > mht->mht_mask)
-    {
-	if (mf_hash_grow(mht) == FAIL)
-	{
-	    /* stop trying to grow after first failure to allocate memory */
-	    mht->mht_fixed = 1;
-	}
-    }
+    if ((mht->mht_count + 1) * 2 > mht->mht_mask + 1
+	    && mf_hash_grow(mht) == FAIL
+	    && mht->mht_count + 1 >= mht->mht_mask)
+	return FAIL;
+
+    mf_hash_put_slot(mht->mht_slots, mht->mht_mask, mhi);
+    mht->mht_count++;
+    return OK;
 }
 
 /*
  * Remove item "mhi" from hashtable "mht".
- * "mhi" must not be NULL and must have been inserted into "mht".
+ * "mhi" must be present in hashtable.
  */
     static void
 mf_hash_rem_item(mht, mhi)
     mf_hashtab_T    *mht;
     mf_hashitem_T   *mhi;
 {
-    if (mhi->mhi_prev == NULL)
-	mht->mht_buckets[mhi->mhi_key & mht->mht_mask] = mhi->mhi_next;
-    else
-	mhi->mhi_prev->mhi_next = mhi->mhi_next;
+    mf_hashslot_T   *slots = mht->mht_slots;
+    long_u	    mask = mht->mht_mask;
+    long_u	    idx;
+    long_u	    next;
+    long_u	    home;
 
-    if (mhi->mhi_next != NULL)
-	mhi->mhi_next->mhi_prev = mhi->mhi_prev;
+    idx = (long_u)mhi->mhi_key & mask;
+    while (slots[idx].mhs_item != mhi)
+	idx = (idx + 1) & mask;
 
-    mht->mht_count--;
+    /*
+     * Move following items that can't be found anymore when the slot is
+     * empty into it, so that no probe sequence is interrupted.  An item can
+     * be moved when the slot for its key is not between the empty slot and
+     * the item itself.
+     */
+    for (next = (idx + 1) & mask; slots[next].mhs_item != NULL;
+						       next = (next + 1) & mask)
+    {
+	home = (long_u)slots[next].mhs_key & mask;
+	if (((next - home) & mask) >= ((next - idx) & mask))
+	{
+	    slots[idx] = slots[next];
+	    idx = next;
+	}
+    }
+    slots[idx].mhs_item = NULL;
 
-    /* We could shrink the table here, but it typically takes little memory,
-     * so why bother?  */
+    mht->mht_count--;
 }
 
 /*
- * Increase number of buckets in the hashtable by MHT_GROWTH_FACTOR and
- * rehash items.
+ * Increase number of slots (capacity) of hashtable "mht" by a factor of
+ * MHT_GROWTH_FACTOR.
  * Returns FAIL when out of memory.
  */
     static int
 mf_hash_grow(mht)
     mf_hashtab_T    *mht;
 {
-    long_u	    i, j;
-    int		    shift;
-    mf_hashitem_T   *mhi;
-    mf_hashitem_T   *tails[MHT_GROWTH_FACTOR];
-    mf_hashitem_T   **buckets;
-    size_t	    size;
-
-    size = (mht->mht_mask + 1) * MHT_GROWTH_FACTOR * sizeof(void *);
-    buckets = (mf_hashitem_T **)lalloc_clear(size, FALSE);
-    if (buckets == NULL)
+    long_u	    i;
+    long_u	    mask;
+    mf_hashslot_T   *slots;
+
+    mask = (mht->mht_mask + 1) * MHT_GROWTH_FACTOR - 1;
+    slots = (mf_hashslot_T *)lalloc_clear(
+			     (long_u)(mask + 1) * sizeof(mf_hashslot_T), FALSE);
+    if (slots == NULL)
 	return FAIL;
 
-    shift = 0;
-    while ((mht->mht_mask >> shift) != 0)
-	shift++;
-
     for (i = 0; i <= mht->mht_mask; i++)
-    {
-	/*
-	 * Traverse the items in the i-th original bucket and move them into
-	 * MHT_GROWTH_FACTOR new buckets, preserving their relative order
-	 * within each new bucket.  Preserving the order is important because
-	 * mf_get() tries to keep most recently used items at the front of
-	 * each bucket.
-	 *
-	 * Here we strongly rely on the fact the hashes are computed modulo
-	 * a power of two.
-	 */
-
-	vim_memset(tails, 0, sizeof(tails));
-
-	for (mhi = mht->mht_buckets[i]; mhi != NULL; mhi = mhi->mhi_next)
-	{
-	    j = (mhi->mhi_key >> shift) & (MHT_GROWTH_FACTOR - 1);
-	    if (tails[j] == NULL)
-	    {
-		buckets[i + (j << shift)] = mhi;
-		tails[j] = mhi;
-		mhi->mhi_prev = NULL;
-	    }
-	    else
-	    {
-		tails[j]->mhi_next = mhi;
-		mhi->mhi_prev = tails[j];
-		tails[j] = mhi;
-	    }
-	}
-
-	for (j = 0; j < MHT_GROWTH_FACTOR; j++)
-	    if (tails[j] != NULL)
-		tails[j]->mhi_next = NULL;
-    }
+	if (mht->mht_slots[i].mhs_item != NULL)
+	    mf_hash_put_slot(slots, mask, mht->mht_slots[i].mhs_item);
 
-    if (mht->mht_buckets != mht->mht_small_buckets)
-	vim_free(mht->mht_buckets);
+    if (mht->mht_slots != mht->mht_small_slots)
+	vim_free(mht->mht_slots);
 
-    mht->mht_buckets = buckets;
-    mht->mht_mask = (mht->mht_mask + 1) * MHT_GROWTH_FACTOR - 1;
+    mht->mht_slots = slots;
+    mht->mht_mask = mask;
 
     return OK;
 }
@@ -25,7 +25,12 @@
 #define index_to_key(i) ((i) ^ 15167)
 #define TEST_COUNT 50000
 
+#define BLOCK_COUNT 20000
+#define LOOKUP_COUNT 2000000L
+
 static void test_mf_hash __ARGS((void));
+static void test_mf_get_put __ARGS((char *fname, long lookups));
+static void test_mf_compress __ARGS((void));
 
 /*
  * Test mf_hash_*() functions.
@@ -37,7 +42,7 @@ test_mf_hash()
     mf_hashitem_T  *item;
     blocknr_T      key;
     long_u	   i;
-    long_u	   num_buckets;
+    long_u	   num_slots;
 
     mf_hash_init(&ht);
 
@@ -46,23 +51,23 @@ test_mf_hash()
     {
 	assert(ht.mht_count == i);
 
-	/* check that number of buckets is a power of 2 */
-	num_buckets = ht.mht_mask + 1;
-	assert(num_buckets > 0 && (num_buckets & (num_buckets - 1)) == 0);
+	/* check that number of slots is a power of 2 */
+	num_slots = ht.mht_mask + 1;
+	assert(num_slots > 0 && (num_slots & (num_slots - 1)) == 0);
 
-	/* check load factor */
-	assert(ht.mht_count <= (num_buckets << MHT_LOG_LOAD_FACTOR));
+	/* check load factor: at least half of the slots is empty */
+	assert(ht.mht_count * 2 <= num_slots);
 
-	if (i < (MHT_INIT_SIZE << MHT_LOG_LOAD_FACTOR))
+	if (i <= MHT_INIT_SIZE / 2)
 	{
 	    /* first expansion shouldn't have occurred yet */
-	    assert(num_buckets == MHT_INIT_SIZE);
-	    assert(ht.mht_buckets == ht.mht_small_buckets);
+	    assert(num_slots == MHT_INIT_SIZE);
+	    assert(ht.mht_slots == ht.mht_small_slots);
 	}
 	else
 	{
-	    assert(num_buckets > MHT_INIT_SIZE);
-	    assert(ht.mht_buckets != ht.mht_small_buckets);
+	    assert(num_slots > MHT_INIT_SIZE);
+	    assert(ht.mht_slots != ht.mht_small_slots);
 	}
 
 	key = index_to_key(i);
@@ -76,11 +81,11 @@ test_mf_hash()
 
 	assert(mf_hash_find(&ht, key) == item);
 
-	if (ht.mht_mask + 1 != num_buckets)
+	if (ht.mht_mask + 1 != num_slots)
 	{
 	    /* hash table was expanded */
-	    assert(ht.mht_mask + 1 == num_buckets * MHT_GROWTH_FACTOR);
-	    assert(i + 1 == (num_buckets << MHT_LOG_LOAD_FACTOR));
+	    assert(ht.mht_mask + 1 == num_slots * MHT_GROWTH_FACTOR);
+	    assert(i == num_slots / 2);
 	}
     }
 
@@ -137,9 +142,156 @@ test_mf_hash()
     mf_hash_free_all(&ht);
 }
 
+/*
+ * Test mf_new(), mf_get() and mf_put() and report how long the lookups take.
+ * Without a file all blocks stay in memory, this measures finding a block.
+ * With a file only 'maxmem' worth of blocks are kept in memory, this checks
+ * that releasing blocks and reading them back works.
+ */
+    static void
+test_mf_get_put(fname, lookups)
+    char	*fname;
+    long	lookups;
+{
+    memfile_T	*mfp;
+    bhdr_T	*hp;
+    blocknr_T	nr;
+    long_u	seed = 1;
+    long	i;
+    clock_t	start;
+#ifdef FEAT_CRYPT
+    buf_T	buf;
+#endif
+
+    p_mm = 400;		/* Kbyte, a hundred 4K blocks */
+    p_mmt = 100000;
+    if (fname != NULL)
+	mch_remove((char_u *)fname);	/* left behind by a crash */
+    mfp = mf_open(fname == NULL ? NULL : vim_strsave((char_u *)fname),
+						 O_CREAT | O_RDWR | O_TRUNC);
+    assert(mfp != NULL);
+    assert(fname == NULL || mfp->mf_fd >= 0);
+#ifdef FEAT_CRYPT
+    /* blocks are only encrypted when 'key' is set */
+    vim_memset(&buf, 0, sizeof(buf));
+    buf.b_p_key = (char_u *)"";
+    mfp->mf_buffer = &buf;
+#endif
+
+    for (i = 0; i < BLOCK_COUNT; i++)
+    {
+	hp = mf_new(mfp, FALSE, 1);
+	assert(hp != NULL);
+	assert(hp->bh_bnum == i);
+	*(long *)hp->bh_data = i ^ 12345;
+	mf_put(mfp, hp, TRUE, FALSE);
+    }
+
+    start = clock();
+    for (i = 0; i < lookups; i++)
+    {
+	/* Mostly use a few blocks near each other, like when editing, with
+	 * now and then a jump to a random block. */
+	seed = seed * 1103515245 + 12345;
+	if ((seed >> 16) % 16 == 0)
+	    nr = (seed >> 8) % BLOCK_COUNT;
+	else
+	    nr = (i / 1000 * 17 + (seed >> 16) % 8) % BLOCK_COUNT;
+	hp = mf_get(mfp, nr, 1);
+	assert(hp != NULL);
+	assert(hp->bh_bnum == nr);
+	assert(*(long *)hp->bh_data == (nr ^ 12345));
+	mf_put(mfp, hp, FALSE, FALSE);
+    }
+    printf("mf_get()/mf_put() %s file: %ld lookups in %ld msec\n",
+	    fname == NULL ? "without" : "with", lookups,
+	    (long)((clock() - start) * 1000 / CLOCKS_PER_SEC));
+
+    mf_close(mfp, TRUE);
+}
+
+/*
+ * Test mf_compress() and mf_decompress(), and compressing blocks when
+ * 'memcompress' is set.
+ */
+    static void
+test_mf_compress()
+{
+    char_u	src[4096];
+    char_u	comp[4096];
+    char_u	dest[4096];
+    unsigned	len;
+    unsigned	clen;
+    long_u	seed = 1;
+    memfile_T	*mfp;
+    bhdr_T	*hp;
+    int		kind;
+    long	i;
+
+    for (kind = 0; kind < 4; ++kind)
+    {
+	len = kind == 3 ? 100 : sizeof(src);
+	for (i = 0; i < (long)len; ++i)
+	{
+	    seed = seed * 1103515245 + 12345;
+	    if (kind == 0 || kind == 3)	/* text */
+		src[i] = "the quick brown fox\n"[(i * 7 + i / 50) % 20];
+	    else if (kind == 1)		/* empty space */
+		src[i] = 0;
+	    else			/* random */
+		src[i] = (char_u)(seed >> 16);
+	}
+	clen = mf_compress(src, len, comp, sizeof(comp));
+	if (kind == 2)
+	{
+	    /* random data does not fit in less space */
+	    assert(mf_compress(src, len, comp, len - len / 4) == 0);
+	    continue;
+	}
+	assert(clen > 0 && clen < len);
+	assert(mf_decompress(comp, clen, dest, len) == OK);
+	assert(memcmp(src, dest, len) == 0);
+
+	/* truncated data or the wrong size must be detected */
+	assert(mf_decompress(comp, clen - 1, dest, len) == FAIL);
+	assert(mf_decompress(comp, clen, dest, len - 1) == FAIL);
+    }
+
+    /* Without a file blocks over 'maxmem' are compressed. */
+    p_mm = 40;		/* Kbyte, ten 4K blocks */
+    p_mmt = 100000;
+    p_mcp = TRUE;
+    mfp = mf_open(NULL, 0);
+    assert(mfp != NULL);
+    for (i = 0; i < 100; i++)
+    {
+	hp = mf_new(mfp, FALSE, 1);
+	assert(hp != NULL);
+	vim_memset(hp->bh_data, ' ', mfp->mf_page_size);
+	*(long *)hp->bh_data = i ^ 12345;
+	mf_put(mfp, hp, TRUE, FALSE);
+    }
+    assert(mfp->mf_comp_count > 50);
+    assert(mfp->mf_used_count <= mfp->mf_used_count_max);
+    for (i = 0; i < 100; i++)
+    {
+	hp = mf_get(mfp, (blocknr_T)i, 1);
+	assert(hp != NULL);
+	assert(hp->bh_csize == 0);
+	assert(*(long *)hp->bh_data == (i ^ 12345));
+	assert(hp->bh_data[mfp->mf_page_size - 1] == ' ');
+	mf_put(mfp, hp, FALSE, FALSE);
+    }
+    mf_close(mfp, TRUE);
+    p_mcp = FALSE;
+}
+
     int
 main()
 {
     test_mf_hash();
+    test_mf_get_put(NULL, LOOKUP_COUNT);
+    test_mf_get_put("Xmemfile_test", LOOKUP_COUNT / 10);
+    test_mf_compress();
     return 0;
 }
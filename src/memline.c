@@ -254,6 +254,8 @@ static void ml_flush_line __ARGS((buf_T *));
 static bhdr_T *ml_new_data __ARGS((memfile_T *, int, int));
 static bhdr_T *ml_new_ptr __ARGS((memfile_T *));
 static bhdr_T *ml_find_line __ARGS((buf_T *, linenr_T, int));
+static bhdr_T *ml_cache_find __ARGS((buf_T *, linenr_T));
+static void ml_cache_add __ARGS((buf_T *, bhdr_T *, linenr_T, linenr_T));
 static int ml_add_stack __ARGS((buf_T *));
 static void ml_lineadd __ARGS((buf_T *, int));
 static int b0_magic_wrong __ARGS((ZERO_BL *));
@@ -270,6 +272,9 @@ static cryptstate_T *ml_crypt_prepare __ARGS((memfile_T *mfp, off_t offset, int
 #endif
 #ifdef FEAT_BYTEOFF
 static void ml_updatechunk __ARGS((buf_T *buf, long line, long len, int updtype));
+static int ml_chunktree_build __ARGS((buf_T *buf));
+static void ml_chunktree_add __ARGS((buf_T *buf, int idx, int lines, long size));
+static int ml_chunktree_find __ARGS((buf_T *buf, linenr_T lnum, long offset, int ffdos, linenr_T *linep, long *sizep));
 #endif
 
 /*
@@ -295,8 +300,15 @@ ml_open(buf)
     buf->b_ml.ml_stack_top = 0;	/* nothing in the stack */
     buf->b_ml.ml_locked = NULL;	/* no cached block */
     buf->b_ml.ml_line_lnum = 0;	/* no cached line */
+    buf->b_ml.ml_cache = NULL;	/* no block cache yet */
+    buf->b_ml.ml_cache_len = 0;
+    buf->b_ml.ml_cache_hits = 0;
+    buf->b_ml.ml_cache_misses = 0;
 #ifdef FEAT_BYTEOFF
     buf->b_ml.ml_chunksize = NULL;
+    buf->b_ml.ml_chunktree = NULL;
+    buf->b_ml.ml_chunktree_len = 0;
+    buf->b_ml.ml_chunktree_valid = FALSE;
 #endif
 
     if (cmdmod.noswapfile)
@@ -534,6 +546,7 @@ ml_set_crypt_key(buf, old_key, old_cm)
 	vim_free(buf->b_ml.ml_stack);
 	buf->b_ml.ml_stack = NULL;
 	buf->b_ml.ml_stack_size = 0;	/* no stack yet */
+	buf->b_ml.ml_cache_len = 0;	/* block cache is invalid now */
 
 	for ( ; !got_int; line_breakcheck())
 	{
@@ -846,9 +859,16 @@ ml_close(buf, del_file)
     if (buf->b_ml.ml_line_lnum != 0 && (buf->b_ml.ml_flags & ML_LINE_DIRTY))
 	vim_free(buf->b_ml.ml_line_ptr);
     vim_free(buf->b_ml.ml_stack);
+    vim_free(buf->b_ml.ml_cache);
+    buf->b_ml.ml_cache = NULL;
+    buf->b_ml.ml_cache_len = 0;
 #ifdef FEAT_BYTEOFF
     vim_free(buf->b_ml.ml_chunksize);
     buf->b_ml.ml_chunksize = NULL;
+    vim_free(buf->b_ml.ml_chunktree);
+    buf->b_ml.ml_chunktree = NULL;
+    buf->b_ml.ml_chunktree_len = 0;
+    buf->b_ml.ml_chunktree_valid = FALSE;
 #endif
     buf->b_ml.ml_mfp = NULL;
 
@@ -1212,6 +1232,8 @@ ml_recover()
     buf->b_ml.ml_stack_top = 0;		/* nothing in the stack */
     buf->b_ml.ml_line_lnum = 0;		/* no cached line */
     buf->b_ml.ml_locked = NULL;		/* no locked block */
+    buf->b_ml.ml_cache = NULL;		/* no block cache */
+    buf->b_ml.ml_cache_len = 0;
     buf->b_ml.ml_flags = 0;
 #ifdef FEAT_CRYPT
     buf->b_p_key = empty_option;
@@ -2357,6 +2379,7 @@ ml_preserve(buf, message)
 
     /* stack is invalid after mf_sync(.., MFS_ALL) */
     buf->b_ml.ml_stack_top = 0;
+    buf->b_ml.ml_cache_len = 0;
 
     /*
      * Some of the data blocks may have been changed from negative to
@@ -2402,6 +2425,44 @@ theend:
     }
 }
 
+/*
+ * ":swapstats": show statistics about the memline of the current buffer.
+ */
+    void
+ex_swapstats(eap)
+    exarg_T	*eap UNUSED;
+{
+    memfile_T	*mfp = curbuf->b_ml.ml_mfp;
+#ifdef FEAT_PROFILE
+    char_u	total[50];
+#endif
+
+    if (mfp == NULL)
+    {
+	MSG(_("No memline"));
+	return;
+    }
+    smsg((char_u *)_("line cache: %ld hits, %ld misses"),
+		       curbuf->b_ml.ml_cache_hits, curbuf->b_ml.ml_cache_misses);
+    if (mfp->mf_comp_count > 0)
+	smsg((char_u *)_("compressed: %ld blocks in %ld bytes"),
+				 mfp->mf_comp_count, (long)mfp->mf_comp_size);
+    if (mfp->mf_fname == NULL)
+    {
+	MSG(_("No swap file"));
+	return;
+    }
+    smsg((char_u *)_("swap file: %d blocks to be written, %ld blocks written"),
+				   mf_dirty_count(mfp), mfp->mf_stat_writes);
+    smsg((char_u *)_("%ld syncs, %ld flushes, %ld flushes postponed"),
+	       mfp->mf_stat_syncs, mfp->mf_stat_flushes, mfp->mf_stat_postponed);
+#ifdef FEAT_PROFILE
+    STRCPY(total, profile_msg(&mfp->mf_stat_total));
+    smsg((char_u *)_("sync time: %s total, %s slowest"), skipwhite(total),
+		      skipwhite((char_u *)profile_msg(&mfp->mf_stat_slowest)));
+#endif
+}
+
 /*
  * NOTE: The pointer returned by the ml_get_*() functions only remains valid
  * until the next call!
@@ -2543,6 +2604,9 @@ ml_line_alloced()
  * Append a line after lnum (may be 0 to insert a line in front of the file).
  * "line" does not need to be allocated, but can't be another line in a
  * buffer, unlocking may make it invalid.
+ * When "len" is not zero the byte at line[len - 1] is not used, it is
+ * replaced with a NUL in the data block.  Thus the text does not need to be
+ * NUL terminated, readfile() uses this to avoid writing into a mapped file.
  *
  *   newfile: TRUE when starting to edit a new file, meaning that pe_old_lnum
  *		will be set for recovery
@@ -2651,10 +2715,15 @@ ml_append_int(buf, lnum, line, len, newfile, mark)
  * - there is not enough room in the current block
  * - appending to the last line in the block
  * - not appending to the last line in the file
+ * - not appending many lines (ML_APPEND_BULK)
  * insert in front of the next block.
+ * When appending many lines they go into a new block, otherwise the text in
+ * the next block would be moved for every line.  The new block is filled
+ * by the following lines, like when appending at the end of the file.
  */
     if ((int)dp->db_free < space_needed && db_idx == line_count - 1
-					    && lnum < buf->b_ml.ml_line_count)
+					    && lnum < buf->b_ml.ml_line_count
+				&& !(buf->b_ml.ml_flags & ML_APPEND_BULK))
     {
 	/*
 	 * Now that the line is not going to be inserted in the block that we
@@ -2712,7 +2781,9 @@ ml_append_int(buf, lnum, line, len, newfile, mark)
 	/*
 	 * copy the text into the block
 	 */
-	mch_memmove((char *)dp + dp->db_index[db_idx + 1], line, (size_t)len);
+	mch_memmove((char *)dp + dp->db_index[db_idx + 1], line,
+							    (size_t)len - 1);
+	((char_u *)dp)[dp->db_index[db_idx + 1] + len - 1] = NUL;
 	if (mark)
 	    dp->db_index[db_idx + 1] |= DB_MARKED;
 
@@ -2830,7 +2901,8 @@ ml_append_int(buf, lnum, line, len, newfile, mark)
 		dp_right->db_index[0] |= DB_MARKED;
 
 	    mch_memmove((char *)dp_right + dp_right->db_txt_start,
-							   line, (size_t)len);
+						       line, (size_t)len - 1);
+	    ((char_u *)dp_right)[dp_right->db_txt_start + len - 1] = NUL;
 	    ++line_count_right;
 	}
 	/*
@@ -2870,7 +2942,8 @@ ml_append_int(buf, lnum, line, len, newfile, mark)
 	    if (mark)
 		dp_left->db_index[line_count_left] |= DB_MARKED;
 	    mch_memmove((char *)dp_left + dp_left->db_txt_start,
-							   line, (size_t)len);
+						       line, (size_t)len - 1);
+	    ((char_u *)dp_left)[dp_left->db_txt_start + len - 1] = NUL;
 	    ++line_count_left;
 	}
 
@@ -3078,9 +3151,9 @@ ml_append_int(buf, lnum, line, len, newfile, mark)
 #ifdef FEAT_NETBEANS_INTG
     if (netbeans_active())
     {
-	if (STRLEN(line) > 0)
-	    netbeans_inserted(buf, lnum+1, (colnr_T)0, line, (int)STRLEN(line));
-	netbeans_inserted(buf, lnum+1, (colnr_T)STRLEN(line),
+	if (len > 1)
+	    netbeans_inserted(buf, lnum+1, (colnr_T)0, line, (int)len - 1);
+	netbeans_inserted(buf, lnum+1, (colnr_T)len - 1,
 							   (char_u *)"\n", 1);
     }
 #endif
@@ -3612,6 +3685,11 @@ ml_find_line(buf, lnum, action)
 
     mfp = buf->b_ml.ml_mfp;
 
+    /* Inserting or deleting a line changes the line numbers of all blocks
+     * after it, the cached line ranges are no longer valid. */
+    if (action == ML_INSERT || action == ML_DELETE)
+	buf->b_ml.ml_cache_len = 0;
+
     /*
      * If there is a locked block check if the wanted line is in it.
      * If not, flush and release the locked block.
@@ -3655,6 +3733,14 @@ ml_find_line(buf, lnum, action)
     if (action == ML_FLUSH)	    /* nothing else to do */
 	return NULL;
 
+    if (action == ML_FIND && !mf_dont_release)
+    {
+	/* try the recently used data blocks */
+	if ((hp = ml_cache_find(buf, lnum)) != NULL)
+	    return hp;
+	++buf->b_ml.ml_cache_misses;
+    }
+
     bnum = 1;			    /* start at the root of the tree */
     page_count = 1;
     low = 1;
@@ -3704,6 +3790,8 @@ ml_find_line(buf, lnum, action)
 	    buf->b_ml.ml_locked_high = high;
 	    buf->b_ml.ml_locked_lineadd = 0;
 	    buf->b_ml.ml_flags &= ~(ML_LOCKED_DIRTY | ML_LOCKED_POS);
+	    if (action == ML_FIND && !mf_dont_release)
+		ml_cache_add(buf, hp, low, high);
 	    return hp;
 	}
 
@@ -3791,6 +3879,108 @@ error_noblock:
     return NULL;
 }
 
+/*
+ * Look for line "lnum" in the cache of recently used data blocks.
+ * When found the block is locked and the stack is restored as if
+ * ml_find_line() walked the tree to it.
+ * Return NULL when not found.
+ */
+    static bhdr_T *
+ml_cache_find(buf, lnum)
+    buf_T	*buf;
+    linenr_T	lnum;
+{
+    mlcache_T	*mc = NULL;
+    mlcache_T	found;
+    bhdr_T	*hp;
+    int		i;
+
+    for (i = 0; i < buf->b_ml.ml_cache_len; ++i)
+    {
+	mc = &buf->b_ml.ml_cache[i];
+	if (mc->mc_low <= lnum && mc->mc_high >= lnum)
+	    break;
+    }
+    if (i == buf->b_ml.ml_cache_len)
+	return NULL;
+
+    /* A data block with a negative number may have been given a positive
+     * number since it was cached, then mf_get() fails and ml_find_line()
+     * must walk the tree to translate the number in the pointer block. */
+    found = *mc;
+    if (found.mc_stack_top > buf->b_ml.ml_stack_size
+	    || (hp = mf_get(buf->b_ml.ml_mfp, found.mc_bnum,
+						 found.mc_page_count)) == NULL)
+    {
+	--buf->b_ml.ml_cache_len;
+	mch_memmove(mc, mc + 1,
+		      (size_t)(buf->b_ml.ml_cache_len - i) * sizeof(mlcache_T));
+	return NULL;
+    }
+
+    /* move the entry to the front */
+    mch_memmove(buf->b_ml.ml_cache + 1, buf->b_ml.ml_cache,
+						    (size_t)i * sizeof(mlcache_T));
+    buf->b_ml.ml_cache[0] = found;
+
+    mch_memmove(buf->b_ml.ml_stack, found.mc_stack,
+			     (size_t)found.mc_stack_top * sizeof(infoptr_T));
+    buf->b_ml.ml_stack_top = found.mc_stack_top;
+
+    buf->b_ml.ml_locked = hp;
+    buf->b_ml.ml_locked_low = found.mc_low;
+    buf->b_ml.ml_locked_high = found.mc_high;
+    buf->b_ml.ml_locked_lineadd = 0;
+    buf->b_ml.ml_flags &= ~(ML_LOCKED_DIRTY | ML_LOCKED_POS);
+    ++buf->b_ml.ml_cache_hits;
+    return hp;
+}
+
+/*
+ * Remember data block "hp", holding lines "low" to "high", in the cache of
+ * recently used data blocks, together with the current stack.
+ * Only done for a tree with more than one level of pointer blocks, otherwise
+ * walking the tree is cheap enough.
+ */
+    static void
+ml_cache_add(buf, hp, low, high)
+    buf_T	*buf;
+    bhdr_T	*hp;
+    linenr_T	low;
+    linenr_T	high;
+{
+    mlcache_T	*mc;
+    int		len;
+
+    if (buf->b_ml.ml_stack_top < 2 || buf->b_ml.ml_stack_top > ML_CACHE_DEPTH)
+	return;
+    if (buf->b_ml.ml_cache == NULL)
+    {
+	buf->b_ml.ml_cache = (mlcache_T *)alloc(
+				     (unsigned)sizeof(mlcache_T) * ML_CACHE_SIZE);
+	if (buf->b_ml.ml_cache == NULL)
+	    return;
+	buf->b_ml.ml_cache_len = 0;
+    }
+
+    /* the least recently used entry at the end drops off */
+    len = buf->b_ml.ml_cache_len;
+    if (len == ML_CACHE_SIZE)
+	--len;
+    mch_memmove(buf->b_ml.ml_cache + 1, buf->b_ml.ml_cache,
+						  (size_t)len * sizeof(mlcache_T));
+    buf->b_ml.ml_cache_len = len + 1;
+
+    mc = &buf->b_ml.ml_cache[0];
+    mc->mc_bnum = hp->bh_bnum;
+    mc->mc_page_count = hp->bh_page_count;
+    mc->mc_low = low;
+    mc->mc_high = high;
+    mc->mc_stack_top = buf->b_ml.ml_stack_top;
+    mch_memmove(mc->mc_stack, buf->b_ml.ml_stack,
+			       (size_t)mc->mc_stack_top * sizeof(infoptr_T));
+}
+
 /*
  * add an entry to the info pointer stack
  *
@@ -5009,6 +5199,7 @@ ml_updatechunk(buf, line, len, updtype)
 	buf->b_ml.ml_usedchunks = 1;
 	buf->b_ml.ml_chunksize[0].mlcs_numlines = 1;
 	buf->b_ml.ml_chunksize[0].mlcs_totalsize = 1;
+	buf->b_ml.ml_chunktree_valid = FALSE;
     }
 
     if (updtype == ML_CHNK_UPDLINE && buf->b_ml.ml_line_count == 1)
@@ -5020,6 +5211,7 @@ ml_updatechunk(buf, line, len, updtype)
 	buf->b_ml.ml_chunksize[0].mlcs_numlines = 1;
 	buf->b_ml.ml_chunksize[0].mlcs_totalsize =
 				  (long)STRLEN(buf->b_ml.ml_line_ptr) + 1;
+	buf->b_ml.ml_chunktree_valid = FALSE;
 	return;
     }
 
@@ -5030,12 +5222,11 @@ ml_updatechunk(buf, line, len, updtype)
     if (buf != ml_upd_lastbuf || line != ml_upd_lastline + 1
 	    || updtype != ML_CHNK_ADDLINE)
     {
-	for (curline = 1, curix = 0;
-	     curix < buf->b_ml.ml_usedchunks - 1
-	     && line >= curline + buf->b_ml.ml_chunksize[curix].mlcs_numlines;
-	     curix++)
+	curix = ml_chunktree_find(buf, line, 0L, 0, &curline, &size);
+	if (curix < 0)
 	{
-	    curline += buf->b_ml.ml_chunksize[curix].mlcs_numlines;
+	    buf->b_ml.ml_usedchunks = -1;
+	    return;
 	}
     }
     else if (line >= curline + buf->b_ml.ml_chunksize[curix].mlcs_numlines
@@ -5050,6 +5241,8 @@ ml_updatechunk(buf, line, len, updtype)
     if (updtype == ML_CHNK_DELLINE)
 	len = -len;
     curchnk->mlcs_totalsize += len;
+    ml_chunktree_add(buf, curix, updtype == ML_CHNK_ADDLINE ? 1
+				 : updtype == ML_CHNK_DELLINE ? -1 : 0, len);
     if (updtype == ML_CHNK_ADDLINE)
     {
 	curchnk->mlcs_numlines++;
@@ -5079,6 +5272,7 @@ ml_updatechunk(buf, line, len, updtype)
 	    int	    text_end;
 	    int	    linecnt;
 
+	    buf->b_ml.ml_chunktree_valid = FALSE;
 	    mch_memmove(buf->b_ml.ml_chunksize + curix + 1,
 			buf->b_ml.ml_chunksize + curix,
 			(buf->b_ml.ml_usedchunks - curix) *
@@ -5135,6 +5329,7 @@ ml_updatechunk(buf, line, len, updtype)
 	     */
 	    curchnk = buf->b_ml.ml_chunksize + curix + 1;
 	    buf->b_ml.ml_usedchunks++;
+	    buf->b_ml.ml_chunktree_valid = FALSE;
 	    if (line == buf->b_ml.ml_line_count)
 	    {
 		curchnk->mlcs_numlines = 0;
@@ -5180,6 +5375,7 @@ ml_updatechunk(buf, line, len, updtype)
 	else if (curix == 0 && curchnk->mlcs_numlines <= 0)
 	{
 	    buf->b_ml.ml_usedchunks--;
+	    buf->b_ml.ml_chunktree_valid = FALSE;
 	    mch_memmove(buf->b_ml.ml_chunksize, buf->b_ml.ml_chunksize + 1,
 			buf->b_ml.ml_usedchunks * sizeof(chunksize_T));
 	    return;
@@ -5195,6 +5391,7 @@ ml_updatechunk(buf, line, len, updtype)
 	curchnk[-1].mlcs_numlines += curchnk->mlcs_numlines;
 	curchnk[-1].mlcs_totalsize += curchnk->mlcs_totalsize;
 	buf->b_ml.ml_usedchunks--;
+	buf->b_ml.ml_chunktree_valid = FALSE;
 	if (curix < buf->b_ml.ml_usedchunks)
 	{
 	    mch_memmove(buf->b_ml.ml_chunksize + curix,
@@ -5210,6 +5407,125 @@ ml_updatechunk(buf, line, len, updtype)
     ml_upd_lastcurix = curix;
 }
 
+/*
+ * Rebuild the Fenwick tree "ml_chunktree" from "ml_chunksize".  Entry "i"
+ * (counting from one) holds the sums for the (i & -i) chunks up to and
+ * including chunk "i".  Changing the size of one chunk then only needs to
+ * update a few entries, and finding the chunk for a line or byte offset only
+ * needs to look at a few entries.
+ * Return FAIL when out of memory.
+ */
+    static int
+ml_chunktree_build(buf)
+    buf_T	*buf;
+{
+    chunksize_T	*tree;
+    int		count = buf->b_ml.ml_usedchunks;
+    int		i;
+    int		j;
+
+    if (buf->b_ml.ml_chunktree_len < count + 1)
+    {
+	vim_free(buf->b_ml.ml_chunktree);
+	buf->b_ml.ml_chunktree_len = buf->b_ml.ml_numchunks + 1;
+	buf->b_ml.ml_chunktree = (chunksize_T *)alloc(
+		    (unsigned)sizeof(chunksize_T) * buf->b_ml.ml_chunktree_len);
+	if (buf->b_ml.ml_chunktree == NULL)
+	{
+	    buf->b_ml.ml_chunktree_len = 0;
+	    return FAIL;
+	}
+    }
+
+    tree = buf->b_ml.ml_chunktree;
+    mch_memmove(tree + 1, buf->b_ml.ml_chunksize,
+					    (size_t)count * sizeof(chunksize_T));
+    for (i = 1; i <= count; ++i)
+    {
+	j = i + (i & -i);
+	if (j <= count)
+	{
+	    tree[j].mlcs_numlines += tree[i].mlcs_numlines;
+	    tree[j].mlcs_totalsize += tree[i].mlcs_totalsize;
+	}
+    }
+    buf->b_ml.ml_chunktree_valid = TRUE;
+    return OK;
+}
+
+/*
+ * Add "lines" and "size" to chunk "idx" in the Fenwick tree.
+ * Nothing to do when the tree is to be rebuilt anyway.
+ */
+    static void
+ml_chunktree_add(buf, idx, lines, size)
+    buf_T	*buf;
+    int		idx;
+    int		lines;
+    long	size;
+{
+    chunksize_T	*tree = buf->b_ml.ml_chunktree;
+    int		i;
+
+    if (!buf->b_ml.ml_chunktree_valid)
+	return;
+    for (i = idx + 1; i <= buf->b_ml.ml_usedchunks; i += i & -i)
+    {
+	tree[i].mlcs_numlines += lines;
+	tree[i].mlcs_totalsize += size;
+    }
+}
+
+/*
+ * Find the chunk with line "lnum" when it is not zero, or the chunk with byte
+ * "offset" when it is not zero.  "ffdos" is one when a line break is two
+ * bytes.  Never goes beyond the last chunk.
+ * Sets "*linep" to the first line of the chunk and "*sizep" to the number of
+ * bytes before it, not counting the extra byte for "ffdos".
+ * Return the index of the chunk, -1 when out of memory.
+ */
+    static int
+ml_chunktree_find(buf, lnum, offset, ffdos, linep, sizep)
+    buf_T	*buf;
+    linenr_T	lnum;
+    long	offset;
+    int		ffdos;
+    linenr_T	*linep;
+    long	*sizep;
+{
+    chunksize_T	*tp;
+    int		last = buf->b_ml.ml_usedchunks - 1;
+    int		idx = 0;
+    int		step;
+    linenr_T	lines = 0;
+    long	size = 0;
+
+    if (!buf->b_ml.ml_chunktree_valid && ml_chunktree_build(buf) == FAIL)
+	return -1;
+
+    /* Go down the tree, skipping over chunks that end before "lnum" or
+     * "offset". */
+    for (step = 1; step * 2 <= last; step *= 2)
+	;
+    for ( ; step > 0; step /= 2)
+    {
+	if (idx + step > last)
+	    continue;
+	tp = buf->b_ml.ml_chunktree + idx + step;
+	if ((lnum != 0 && lnum > lines + tp->mlcs_numlines)
+		|| (offset != 0 && offset > size + tp->mlcs_totalsize
+				       + ffdos * (lines + tp->mlcs_numlines)))
+	{
+	    idx += step;
+	    lines += tp->mlcs_numlines;
+	    size += tp->mlcs_totalsize;
+	}
+    }
+    *linep = lines + 1;
+    *sizep = size;
+    return idx;
+}
+
 /*
  * Find offset for line or line with offset.
  * Find line with offset if "lnum" is 0; return remaining offset in offp
@@ -5223,7 +5539,6 @@ ml_find_line_or_offset(buf, lnum, offp)
     long	*offp;
 {
     linenr_T	curline;
-    int		curix;
     long	size;
     bhdr_T	*hp;
     DATA_BL	*dp;
@@ -5251,24 +5566,16 @@ ml_find_line_or_offset(buf, lnum, offp)
     if (lnum == 0 && offset <= 0)
 	return 1;   /* Not a "find offset" and offset 0 _must_ be in line 1 */
     /*
-     * Find the last chunk before the one containing our line. Last chunk is
-     * special because it will never qualify
+     * Find the chunk containing our line. Last chunk is special because it
+     * will never qualify
      */
-    curline = 1;
-    curix = size = 0;
-    while (curix < buf->b_ml.ml_usedchunks - 1
-	    && ((lnum != 0
-	     && lnum >= curline + buf->b_ml.ml_chunksize[curix].mlcs_numlines)
-		|| (offset != 0
-	       && offset > size + buf->b_ml.ml_chunksize[curix].mlcs_totalsize
-		      + ffdos * buf->b_ml.ml_chunksize[curix].mlcs_numlines)))
+    if (ml_chunktree_find(buf, lnum, offset, ffdos, &curline, &size) < 0)
     {
-	curline += buf->b_ml.ml_chunksize[curix].mlcs_numlines;
-	size += buf->b_ml.ml_chunksize[curix].mlcs_totalsize;
-	if (offset && ffdos)
-	    size += buf->b_ml.ml_chunksize[curix].mlcs_numlines;
-	curix++;
+	buf->b_ml.ml_usedchunks = -1;
+	return -1;
     }
+    if (offset && ffdos)
+	size += curline - 1;
 
     while ((lnum != 0 && curline < lnum) || (offset != 0 && size < offset))
     {
@@ -2017,11 +2017,21 @@ plines_win_nofold(wp, lnum)
     char_u	*s;
     long	col;
     int		width;
+    pos_T	pos;
+    colnr_T	vcol;
 
     s = ml_get_buf(wp->w_buffer, lnum, FALSE);
     if (*s == NUL)		/* empty line */
 	return 1;
-    col = win_linetabsize(wp, s, (colnr_T)MAXCOL);
+    /* Like win_linetabsize(), but getvcol() can use the positions remembered
+     * in a long line. */
+    pos.lnum = lnum;
+    pos.col = MAXCOL;
+#ifdef FEAT_VIRTUALEDIT
+    pos.coladd = 0;
+#endif
+    getvcol(wp, &pos, &vcol, NULL, NULL);
+    col = vcol;
 
     /*
      * If list mode is on, then the '$' at the end of the line may take up one
@@ -3108,6 +3118,24 @@ changed_common(lnum, col, lnume, xtra)
 	    if (wp->w_redr_type < VALID)
 		wp->w_redr_type = VALID;
 
+	    /* Remembered virtual columns after the change are invalid. */
+	    getvcol_changed(wp, lnum, col, lnume, xtra);
+
+	    /* Lines to be redrawn below the change have moved.  Do this
+	     * before foldUpdate(), it may set them for the new lines. */
+	    if (wp->w_redraw_top != 0 && xtra != 0)
+	    {
+		if (wp->w_redraw_top >= lnume)
+		    wp->w_redraw_top += xtra;
+		else if (wp->w_redraw_top > lnum)
+		    wp->w_redraw_top = lnum;
+		if (wp->w_redraw_bot >= lnume)
+		    wp->w_redraw_bot += xtra;
+		else if (wp->w_redraw_bot >= lnum)
+		    wp->w_redraw_bot = lnume + xtra - 1 < lnum
+						     ? lnum : lnume + xtra - 1;
+	    }
+
 	    /* Check if a change in the buffer has invalidated the cached
 	     * values for the cursor. */
 #ifdef FEAT_FOLDING
@@ -3189,8 +3217,10 @@ changed_common(lnum, col, lnume, xtra)
 	    if (hasAnyFolding(wp))
 		set_topline(wp, wp->w_topline);
 #endif
-	    /* relative numbering may require updating more */
-	    if (wp->w_p_rnu)
+	    /* Relative numbering may require updating more.  When the
+	     * cursor is above the change only the lines below it get other
+	     * numbers, win_update() takes care of that. */
+	    if (wp->w_p_rnu && xtra != 0 && wp->w_cursor.lnum >= lnum)
 		redraw_win_later(wp, SOME_VALID);
 	}
     }
@@ -3231,6 +3261,11 @@ unchanged(buf, ff)
 #endif
     }
     ++buf->b_changedtick;
+#ifdef FEAT_PERSISTENT_UNDO
+    /* The text didn't change, the hash of it is still valid. */
+    if (buf->b_u_hash_tick == buf->b_changedtick - 1)
+	buf->b_u_hash_tick = buf->b_changedtick;
+#endif
 #ifdef FEAT_NETBEANS_INTG
     netbeans_unmodified(buf);
 #endif
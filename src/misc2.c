@@ -196,7 +196,8 @@ coladvance2(pos, addspaces, finetune, wcol)
 	}
 #endif
 
-	ptr = line;
+	/* In a long line start at a remembered position. */
+	ptr = line + getvcol_start(curwin, pos->lnum, line, wcol, &col);
 	while (col <= wcol && *ptr != NUL)
 	{
 	    /* Count a tab for what it's worth (if list mode not on) */
@@ -1877,7 +1878,9 @@ vim_strchr(string, c)
     int		c;
 {
     char_u	*p;
+#ifdef FEAT_MBYTE
     int		b;
+#endif
 
     p = string;
 #ifdef FEAT_MBYTE
@@ -1907,7 +1910,7 @@ vim_strchr(string, c)
 	}
 	return NULL;
     }
-    if (has_mbyte)
+    if (has_mbyte && !(enc_utf8 && c < 0x80))
     {
 	while ((b = *p) != NUL)
 	{
@@ -1918,13 +1921,12 @@ vim_strchr(string, c)
 	return NULL;
     }
 #endif
-    while ((b = *p) != NUL)
-    {
-	if (b == c)
-	    return p;
-	++p;
-    }
-    return NULL;
+    /* In UTF-8 an ASCII byte is never part of a multi-byte character, thus
+     * the bytes can be checked just like without multi-byte characters.
+     * strchr() is usually a lot faster than a loop. */
+    if (c <= 0 || c > 255)
+	return NULL;
+    return (char_u *)strchr((char *)p, c);
 }
 
 /*
@@ -1937,15 +1939,9 @@ vim_strbyte(string, c)
     char_u	*string;
     int		c;
 {
-    char_u	*p = string;
-
-    while (*p != NUL)
-    {
-	if (*p == c)
-	    return p;
-	++p;
-    }
-    return NULL;
+    if (c <= 0 || c > 255)
+	return NULL;
+    return (char_u *)strchr((char *)string, c);
 }
 
 /*
@@ -1826,6 +1826,9 @@ static struct vimoption
 			    (char_u *)&p_mmt, PV_NONE,
 			    {(char_u *)DFLT_MAXMEMTOT, (char_u *)0L}
 			    SCRIPTID_INIT},
+    {"memcompress", "mcp",  P_BOOL|P_VI_DEF,
+			    (char_u *)&p_mcp, PV_NONE,
+			    {(char_u *)FALSE, (char_u *)0L} SCRIPTID_INIT},
     {"menuitems",   "mis",  P_NUM|P_VI_DEF,
 #ifdef FEAT_MENU
 			    (char_u *)&p_mis, PV_NONE,
@@ -2531,6 +2534,13 @@ static struct vimoption
 			    {(char_u *)0L, (char_u *)0L}
 #endif
 			    SCRIPTID_INIT},
+    {"syntaxcache", "syc",  P_BOOL|P_VI_DEF,
+#if defined(FEAT_SYN_HL) && defined(FEAT_PERSISTENT_UNDO)
+			    (char_u *)&p_syc, PV_NONE,
+#else
+			    (char_u *)NULL, PV_NONE,
+#endif
+			    {(char_u *)FALSE, (char_u *)0L} SCRIPTID_INIT},
     {"tabline",	    "tal",  P_STRING|P_VI_DEF|P_RALL,
 #ifdef FEAT_STL_OPT
 			    (char_u *)&p_tal, PV_NONE,
@@ -2958,6 +2968,7 @@ static struct vimoption
     p_term("t_nd", T_ND)
     p_term("t_op", T_OP)
     p_term("t_RI", T_CRI)
+    p_term("t_RP", T_RP)
     p_term("t_RV", T_CRV)
     p_term("t_u7", T_U7)
     p_term("t_Sb", T_CSB)
@@ -2979,6 +2990,8 @@ static struct vimoption
     p_term("t_SI", T_CSI)
     p_term("t_EI", T_CEI)
     p_term("t_SR", T_CSR)
+    p_term("t_BS", T_CBS)
+    p_term("t_ES", T_CES)
     p_term("t_xn", T_XN)
     p_term("t_xs", T_XS)
     p_term("t_ZH", T_CZH)
@@ -5791,6 +5804,17 @@ did_set_string_option(opt_idx, varp, new_value_alloced, oldval, errbuf,
 	    did_chartab = TRUE;	    /* need to restore it below */
 	    errmsg = e_invarg;	    /* error in value */
 	}
+	else
+	{
+	    /* "\i", "\f" and "\p" may match differently now, remembered
+	     * lines can't be used. */
+	    ++linecache_tick;
+#ifdef FEAT_SYN_HL
+	    /* Syntax keywords may match differently now. */
+	    if (varp == &(curbuf->b_p_isk))
+		syn_stack_free_all(curwin->w_s);
+#endif
+	}
     }
 
     /* 'helpfile' */
@@ -6919,6 +6943,8 @@ did_set_string_option(opt_idx, varp, new_value_alloced, oldval, errbuf,
     {
 	if (opt_strings_flags(p_cmp, p_cmp_values, &cmp_flags, TRUE) != OK)
 	    errmsg = e_invarg;
+	else
+	    regcache_clear();	/* compiled patterns depend on it */
     }
 #endif
 
@@ -8764,7 +8790,10 @@ check_redraw(flags)
 #endif
 
     if ((flags & P_RBUF) || (flags & P_RWIN) || all)
+    {
 	changed_window_setting();
+	++linecache_tick;
+    }
     if (flags & P_RBUF)
 	redraw_curbuf_later(NOT_VALID);
     if (doclear)
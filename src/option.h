@@ -618,6 +618,7 @@ EXTERN long	p_mmd;		/* 'maxmapdepth' */
 EXTERN long	p_mm;		/* 'maxmem' */
 EXTERN long	p_mmp;		/* 'maxmempattern' */
 EXTERN long	p_mmt;		/* 'maxmemtot' */
+EXTERN int	p_mcp;		/* 'memcompress' */
 #ifdef FEAT_MENU
 EXTERN long	p_mis;		/* 'menuitems' */
 #endif
@@ -763,6 +764,9 @@ EXTERN int	p_sol;		/* 'startofline' */
 EXTERN char_u	*p_su;		/* 'suffixes' */
 EXTERN char_u	*p_sws;		/* 'swapsync' */
 EXTERN char_u	*p_swb;		/* 'switchbuf' */
+#if defined(FEAT_SYN_HL) && defined(FEAT_PERSISTENT_UNDO)
+EXTERN int	p_syc;		/* 'syntaxcache' */
+#endif
 EXTERN unsigned	swb_flags;
 #ifdef IN_OPTION_C
 static char *(p_swb_values[]) = {"useopen", "usetab", "split", "newtab", NULL};
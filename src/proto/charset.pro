@@ -30,6 +30,8 @@ int lbr_chartabsize __ARGS((char_u *line, unsigned char *s, colnr_T col));
 int lbr_chartabsize_adv __ARGS((char_u *line, char_u **s, colnr_T col));
 int win_lbr_chartabsize __ARGS((win_T *wp, char_u *line, char_u *s, colnr_T col, int *headp));
 int in_win_border __ARGS((win_T *wp, colnr_T vcol));
+colnr_T getvcol_start __ARGS((win_T *wp, linenr_T lnum, char_u *line, colnr_T wcol, colnr_T *vcolp));
+void getvcol_changed __ARGS((win_T *wp, linenr_T lnum, colnr_T col, linenr_T lnume, long xtra));
 void getvcol __ARGS((win_T *wp, pos_T *pos, colnr_T *start, colnr_T *cursor, colnr_T *end));
 colnr_T getvcol_nolist __ARGS((pos_T *posp));
 void getvvcol __ARGS((win_T *wp, pos_T *pos, colnr_T *start, colnr_T *cursor, colnr_T *end));
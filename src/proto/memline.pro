@@ -13,6 +13,7 @@ void ml_recover __ARGS((void));
 int recover_names __ARGS((char_u *fname, int list, int nr, char_u **fname_out));
 void ml_sync_all __ARGS((int check_file, int check_char));
 void ml_preserve __ARGS((buf_T *buf, int message));
+void ex_swapstats __ARGS((exarg_T *eap));
 char_u *ml_get __ARGS((linenr_T lnum));
 char_u *ml_get_pos __ARGS((pos_T *pos));
 char_u *ml_get_curline __ARGS((void));
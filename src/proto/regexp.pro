@@ -11,10 +11,13 @@ int vim_regsub __ARGS((regmatch_T *rmp, char_u *source, char_u *dest, int copy,
 int vim_regsub_multi __ARGS((regmmatch_T *rmp, linenr_T lnum, char_u *source, char_u *dest, int copy, int magic, int backslash));
 char_u *reg_submatch __ARGS((int no));
 list_T *reg_submatch_list __ARGS((int no));
+void regcache_clear __ARGS((void));
+void ex_regexpstats __ARGS((exarg_T *eap));
 regprog_T *vim_regcomp __ARGS((char_u *expr_arg, int re_flags));
 void vim_regfree __ARGS((regprog_T *prog));
 int vim_regexec_prog __ARGS((regprog_T **prog, int ignore_case, char_u *line, colnr_T col));
 int vim_regexec __ARGS((regmatch_T *rmp, char_u *line, colnr_T col));
 int vim_regexec_nl __ARGS((regmatch_T *rmp, char_u *line, colnr_T col));
 long vim_regexec_multi __ARGS((regmmatch_T *rmp, win_T *win, buf_T *buf, linenr_T lnum, colnr_T col, proftime_T *tm));
+int vim_regline_may_match __ARGS((regmmatch_T *rmp, buf_T *buf, linenr_T lnum));
 /* vim: set ft=c : */
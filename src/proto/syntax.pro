@@ -1,7 +1,11 @@
 /* syntax.c */
 void syntax_start __ARGS((win_T *wp, linenr_T lnum));
+int syntax_uses_cursor __ARGS((win_T *wp));
+void syntax_start_cached __ARGS((win_T *wp, linenr_T lnum));
 void syn_stack_free_all __ARGS((synblock_T *block));
 void syn_stack_apply_changes __ARGS((buf_T *buf));
+void syn_idle_update __ARGS((void));
+void syn_cache_write __ARGS((buf_T *buf));
 void syntax_end_parsing __ARGS((linenr_T lnum));
 int syntax_check_changed __ARGS((linenr_T lnum));
 int get_syntax_attr __ARGS((colnr_T col, int *can_spell, int keep_state));
@@ -9,6 +9,9 @@ int term_is_gui __ARGS((char_u *name));
 char_u *tltoa __ARGS((unsigned long i));
 void termcapinit __ARGS((char_u *name));
 void out_flush __ARGS((void));
+void term_start_frame __ARGS((void));
+int term_end_frame __ARGS((void));
+void term_get_stats __ARGS((dict_T *dict));
 void out_flush_check __ARGS((void));
 void out_trash __ARGS((void));
 void out_char __ARGS((unsigned c));
@@ -16,6 +19,7 @@ void out_str_nf __ARGS((char_u *s));
 void out_str __ARGS((char_u *s));
 void term_windgoto __ARGS((int row, int col));
 void term_cursor_right __ARGS((int i));
+int term_repeat_char __ARGS((int c, int n));
 void term_append_lines __ARGS((int line_count));
 void term_delete_lines __ARGS((int line_count));
 void term_set_winpos __ARGS((int x, int y));
@@ -7,7 +7,11 @@ int u_savedel __ARGS((linenr_T lnum, long nlines));
 int undo_allowed __ARGS((void));
 int u_savecommon __ARGS((linenr_T top, linenr_T bot, linenr_T newbot, int reload));
 void u_compute_hash __ARGS((char_u *hash));
+void u_compute_buf_hash __ARGS((buf_T *buf, char_u *hash));
+void u_set_buf_hash __ARGS((buf_T *buf, char_u *hash));
 char_u *u_get_undo_file_name __ARGS((char_u *buf_ffname, int reading));
+char_u *u_get_cache_file_name __ARGS((char_u *buf_ffname, int reading, char *ext));
+int u_create_cache_file __ARGS((buf_T *buf, char_u *file_name));
 void u_write_undo __ARGS((char_u *name, int forceit, buf_T *buf, char_u *hash));
 void u_read_undo __ARGS((char_u *name, char_u *hash, char_u *orig_name));
 void u_undo __ARGS((int count));
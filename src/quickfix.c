@@ -3372,13 +3372,15 @@ ex_vimgrep(eap)
 	else
 	{
 	    /* Try for a match in all lines of the buffer.
-	     * For ":1vimgrep" look for first match only. */
+	     * For ":1vimgrep" look for first match only.
+	     * Quickly skip lines that can't match. */
 	    found_match = FALSE;
 	    for (lnum = 1; lnum <= buf->b_ml.ml_line_count && tomatch > 0;
 								       ++lnum)
 	    {
 		col = 0;
-		while (vim_regexec_multi(&regmatch, curwin, buf, lnum,
+		while (vim_regline_may_match(&regmatch, buf, lnum)
+			&& vim_regexec_multi(&regmatch, curwin, buf, lnum,
 							       col, NULL) > 0)
 		{
 		    ;
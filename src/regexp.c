@@ -3515,6 +3515,7 @@ typedef struct regbehind_S
 
 static char_u	*reg_getline __ARGS((linenr_T lnum));
 static long	bt_regexec_both __ARGS((char_u *line, colnr_T col, proftime_T *tm));
+static char_u	*find_regmust __ARGS((char_u *s, char_u *must, int *mlenp));
 static long	regtry __ARGS((bt_regprog_T *prog, colnr_T col));
 static void	cleanup_subexpr __ARGS((void));
 #ifdef FEAT_SYN_HL
@@ -3699,6 +3700,7 @@ free_regexp_stuff()
     ga_clear(&backpos);
     vim_free(reg_tofree);
     vim_free(reg_prev_sub);
+    regcache_clear();
 }
 #endif
 
@@ -3765,6 +3767,7 @@ bt_regexec_nl(rmp, line, col, line_lbr)
 }
 
 static long bt_regexec_multi __ARGS((regmmatch_T *rmp, win_T *win, buf_T *buf, linenr_T lnum, colnr_T col, proftime_T *tm));
+static int bt_regline_may_match __ARGS((regprog_T *prog, char_u *line));
 
 /*
  * Match a regexp against multiple lines.
@@ -3799,6 +3802,78 @@ bt_regexec_multi(rmp, win, buf, lnum, col, tm)
     return bt_regexec_both(NULL, col, tm);
 }
 
+/*
+ * Find the "must appear" string "must" with length "*mlenp" in "s".
+ * Returns a pointer to where it was found, NULL when it is not present.
+ */
+    static char_u *
+find_regmust(s, must, mlenp)
+    char_u	*s;
+    char_u	*must;
+    int		*mlenp;
+{
+    int c;
+
+    /* When not ignoring case the bytes can be compared, unless a trail byte
+     * can look like another character.  strstr() is usually a lot faster
+     * than checking every character. */
+    if (!ireg_ic
+#ifdef FEAT_MBYTE
+	    && (!has_mbyte || enc_utf8)
+#endif
+	    )
+	return (char_u *)strstr((char *)s, (char *)must);
+
+#ifdef FEAT_MBYTE
+    if (has_mbyte)
+	c = (*mb_ptr2char)(must);
+    else
+#endif
+	c = *must;
+
+    /*
+     * This is used very often, esp. for ":global".  Use two versions of
+     * the loop to avoid overhead of conditions.
+     */
+#ifdef FEAT_MBYTE
+    if (!ireg_ic || (!enc_utf8 && mb_char2len(c) > 1))
+	while ((s = vim_strchr(s, c)) != NULL)
+	{
+	    if (cstrncmp(s, must, mlenp) == 0)
+		break;		/* Found it. */
+	    mb_ptr_adv(s);
+	}
+    else
+#endif
+	while ((s = cstrchr(s, c)) != NULL)
+	{
+	    if (cstrncmp(s, must, mlenp) == 0)
+		break;		/* Found it. */
+	    mb_ptr_adv(s);
+	}
+    return s;
+}
+
+/*
+ * Return FALSE if bt_regexec_multi() will not find a match starting in
+ * "line", because it does not contain the character the match starts with or
+ * the "must appear" string.  Uses "ireg_ic".
+ */
+    static int
+bt_regline_may_match(prog_arg, line)
+    regprog_T	*prog_arg;
+    char_u	*line;
+{
+    bt_regprog_T *prog = (bt_regprog_T *)prog_arg;
+
+    if (prog->regstart != NUL && cstrchr(line, prog->regstart) == NULL)
+	return FALSE;
+    if (prog->regmust != NULL
+	    && find_regmust(line, prog->regmust, &prog->regmlen) == NULL)
+	return FALSE;
+    return TRUE;
+}
+
 /*
  * Match a regexp against a string ("line" points to the string) or multiple
  * lines ("line" is NULL, use reg_getline()).
@@ -3876,52 +3951,9 @@ bt_regexec_both(line, col, tm)
 #endif
 
     /* If there is a "must appear" string, look for it. */
-    if (prog->regmust != NULL)
-    {
-	int c;
-
-#ifdef FEAT_MBYTE
-	if (has_mbyte)
-	    c = (*mb_ptr2char)(prog->regmust);
-	else
-#endif
-	    c = *prog->regmust;
-	s = line + col;
-
-	/*
-	 * This is used very often, esp. for ":global".  Use three versions of
-	 * the loop to avoid overhead of conditions.
-	 */
-	if (!ireg_ic
-#ifdef FEAT_MBYTE
-		&& !has_mbyte
-#endif
-		)
-	    while ((s = vim_strbyte(s, c)) != NULL)
-	    {
-		if (cstrncmp(s, prog->regmust, &prog->regmlen) == 0)
-		    break;		/* Found it. */
-		++s;
-	    }
-#ifdef FEAT_MBYTE
-	else if (!ireg_ic || (!enc_utf8 && mb_char2len(c) > 1))
-	    while ((s = vim_strchr(s, c)) != NULL)
-	    {
-		if (cstrncmp(s, prog->regmust, &prog->regmlen) == 0)
-		    break;		/* Found it. */
-		mb_ptr_adv(s);
-	    }
-#endif
-	else
-	    while ((s = cstrchr(s, c)) != NULL)
-	    {
-		if (cstrncmp(s, prog->regmust, &prog->regmlen) == 0)
-		    break;		/* Found it. */
-		mb_ptr_adv(s);
-	    }
-	if (s == NULL)		/* Not present. */
-	    goto theend;
-    }
+    if (prog->regmust != NULL && find_regmust(line + col, prog->regmust,
+							    &prog->regmlen) == NULL)
+	goto theend;
 
     regline = line;
     reglnum = 0;
@@ -7198,7 +7230,8 @@ cstrchr(s, c)
 	return vim_strchr(s, c);
 
 #ifdef FEAT_MBYTE
-    if (has_mbyte)
+    /* In UTF-8 an ASCII byte is never part of a multi-byte character. */
+    if (has_mbyte && !(enc_utf8 && c < 0x80))
     {
 	for (p = s; *p != NUL; p += (*mb_ptr2len)(p))
 	{
@@ -8012,6 +8045,7 @@ static regengine_T bt_regengine =
     bt_regfree,
     bt_regexec_nl,
     bt_regexec_multi,
+    bt_regline_may_match,
     (char_u *)""
 };
 
@@ -8023,6 +8057,7 @@ static regengine_T nfa_regengine =
     nfa_regfree,
     nfa_regexec_nl,
     nfa_regexec_multi,
+    nfa_regline_may_match,
     (char_u *)""
 };
 
@@ -8038,11 +8073,201 @@ static char_u regname[][30] = {
 			    };
 #endif
 
+/*
+ * Cache of compiled patterns.  Plugins often call functions like
+ * substitute() and match() in a loop with the same pattern, compiling it each
+ * time can take most of the time.
+ * The key is the pattern text prefixed with everything else that influences
+ * compiling it.  A compiled program is shared by everybody who compiles the
+ * same pattern, "re_refcount" counts the users, including the cache.
+ * The least recently used pattern is dropped when the cache is full.
+ */
+typedef struct regcache_S regcache_T;
+
+struct regcache_S
+{
+    regcache_T	*rc_next;	/* next in list, less recently used */
+    regcache_T	*rc_prev;	/* previous in list, more recently used */
+    regprog_T	*rc_prog;
+    int		rc_had_eol;	/* "had_eol" after compiling */
+    char_u	rc_key[1];	/* flags and pattern, actually longer */
+};
+
+#define REGCACHE_SIZE	50	/* max number of cached patterns */
+
+static hashtab_T	regcache_ht;
+static int		regcache_ht_init = FALSE;
+static regcache_T	*regcache_first = NULL;	/* most recently used */
+static regcache_T	*regcache_last = NULL;	/* least recently used */
+static int		regcache_count = 0;
+static long		regcache_hits = 0;
+static long		regcache_misses = 0;
+static char_u		*regcache_key = NULL;	/* key of last lookup */
+static int		regcache_keylen = 0;	/* allocated size */
+
+static regcache_T	dumrc;
+#define HIKEY2RC(p)  ((regcache_T *)(p - (dumrc.rc_key - (char_u *)&dumrc)))
+#define HI2RC(hi)     HIKEY2RC((hi)->hi_key)
+
+static regcache_T *regcache_find __ARGS((char_u *expr, int re_flags));
+static regcache_T *regcache_new __ARGS((void));
+static void regcache_unlink __ARGS((regcache_T *rc));
+static void regcache_link __ARGS((regcache_T *rc));
+static void regcache_remove __ARGS((regcache_T *rc));
+#ifdef FEAT_RELTIME
+static void regadapt_stats __ARGS((void));
+#endif
+
+/*
+ * Find the cache entry for compiling "expr" with "re_flags" and the current
+ * engine and options.  Returns NULL when it is not found.  Then the key is
+ * kept in "regcache_key" for regcache_new().
+ */
+    static regcache_T *
+regcache_find(expr, re_flags)
+    char_u	*expr;
+    int		re_flags;
+{
+    hashitem_T	*hi;
+    int		len = (int)STRLEN(expr) + 50;
+    int		enc = 0;
+
+    if (len > regcache_keylen)
+    {
+	vim_free(regcache_key);
+	regcache_key = alloc(len);
+	regcache_keylen = regcache_key == NULL ? 0 : len;
+	if (regcache_key == NULL)
+	    return NULL;
+    }
+#ifdef FEAT_MBYTE
+    enc = enc_dbcs != 0 ? enc_dbcs : enc_utf8 ? -2 : has_mbyte;
+#endif
+    sprintf((char *)regcache_key, "%d,%d,%d,%d,%d,%d:%s", re_flags,
+	    regexp_engine, reg_do_extmatch,
+	    vim_strchr(p_cpo, CPO_LITERAL) != NULL,
+	    vim_strchr(p_cpo, CPO_BACKSL) != NULL, enc, expr);
+
+    if (!regcache_ht_init)
+    {
+	hash_init(&regcache_ht);
+	regcache_ht_init = TRUE;
+    }
+    hi = hash_find(&regcache_ht, regcache_key);
+    if (HASHITEM_EMPTY(hi))
+	return NULL;
+    return HI2RC(hi);
+}
+
+/*
+ * Allocate a new cache entry with the key of the last regcache_find().
+ * Returns NULL when out of memory.
+ */
+    static regcache_T *
+regcache_new()
+{
+    regcache_T	*rc;
+
+    if (regcache_key == NULL)
+	return NULL;
+    rc = (regcache_T *)alloc((unsigned)(sizeof(regcache_T)
+						      + STRLEN(regcache_key)));
+    if (rc != NULL)
+	STRCPY(rc->rc_key, regcache_key);
+    return rc;
+}
+
+/*
+ * Remove "rc" from the list of cached patterns.
+ */
+    static void
+regcache_unlink(rc)
+    regcache_T	*rc;
+{
+    if (rc->rc_prev == NULL)
+	regcache_first = rc->rc_next;
+    else
+	rc->rc_prev->rc_next = rc->rc_next;
+    if (rc->rc_next == NULL)
+	regcache_last = rc->rc_prev;
+    else
+	rc->rc_next->rc_prev = rc->rc_prev;
+}
+
+/*
+ * Insert "rc" at the start of the list of cached patterns.
+ */
+    static void
+regcache_link(rc)
+    regcache_T	*rc;
+{
+    rc->rc_prev = NULL;
+    rc->rc_next = regcache_first;
+    if (regcache_first == NULL)
+	regcache_last = rc;
+    else
+	regcache_first->rc_prev = rc;
+    regcache_first = rc;
+}
+
+/*
+ * Remove "rc" from the cache and free it.  The program is only freed when
+ * nobody else is using it.
+ */
+    static void
+regcache_remove(rc)
+    regcache_T	*rc;
+{
+    hashitem_T	*hi;
+
+    hi = hash_find(&regcache_ht, rc->rc_key);
+    if (!HASHITEM_EMPTY(hi))
+	hash_remove(&regcache_ht, hi);
+    regcache_unlink(rc);
+    --regcache_count;
+    vim_regfree(rc->rc_prog);
+    vim_free(rc);
+}
+
+/*
+ * Remove all patterns from the cache.  Also used when something changed that
+ * is not in the key, e.g. the locale that character classes depend on.
+ */
+    void
+regcache_clear()
+{
+    while (regcache_first != NULL)
+	regcache_remove(regcache_first);
+    vim_free(regcache_key);
+    regcache_key = NULL;
+    regcache_keylen = 0;
+
+    /* Programs kept elsewhere, e.g. by syntax items, make their collections
+     * again. */
+    ++nfa_coll_tick;
+}
+
+/*
+ * ":regexpstats": show statistics about compiling patterns.
+ */
+    void
+ex_regexpstats(eap)
+    exarg_T	*eap UNUSED;
+{
+    smsg((char_u *)_("pattern cache: %d patterns, %ld hits, %ld misses"),
+			    regcache_count, regcache_hits, regcache_misses);
+#ifdef FEAT_RELTIME
+    regadapt_stats();
+#endif
+}
+
 /*
  * Compile a regular expression into internal code.
  * Returns the program in allocated memory.
  * Use vim_regfree() to free the memory.
  * Returns NULL for an error.
+ * When the same pattern was compiled recently the program is shared, see
+ * regcache_T.
  */
     regprog_T *
 vim_regcomp(expr_arg, re_flags)
@@ -8051,6 +8276,7 @@ vim_regcomp(expr_arg, re_flags)
 {
     regprog_T   *prog = NULL;
     char_u	*expr = expr_arg;
+    regcache_T	*rc = NULL;
 
     regexp_engine = p_re;
 
@@ -8076,6 +8302,26 @@ vim_regcomp(expr_arg, re_flags)
 	    regexp_engine = AUTOMATIC_ENGINE;
 	}
     }
+    /*
+     * Use a cached program when possible.  Not when the pattern contains a
+     * "~", it includes the previous substitute string.
+     */
+    if (vim_strchr(expr, '~') == NULL)
+    {
+	rc = regcache_find(expr, re_flags);
+	if (rc != NULL)
+	{
+	    ++regcache_hits;
+	    regcache_unlink(rc);
+	    regcache_link(rc);
+	    had_eol = rc->rc_had_eol;
+	    ++rc->rc_prog->re_refcount;
+	    return rc->rc_prog;
+	}
+	++regcache_misses;
+	rc = regcache_new();
+    }
+
     bt_regengine.expr = expr;
     nfa_regengine.expr = expr;
 
@@ -8124,6 +8370,31 @@ vim_regcomp(expr_arg, re_flags)
 	 * out to be very slow when executing it. */
 	prog->re_engine = regexp_engine;
 	prog->re_flags  = re_flags;
+	prog->re_refcount = 1;
+	prog->re_adapt = NULL;
+#ifdef FEAT_RELTIME
+	if (regexp_engine == AUTOMATIC_ENGINE)
+	    prog->re_adapt = (regadapt_T *)alloc_clear(
+						  (unsigned)sizeof(regadapt_T));
+#endif
+    }
+
+    if (rc != NULL)
+    {
+	if (prog == NULL)
+	    vim_free(rc);
+	else
+	{
+	    /* Add to the cache, drop the least recently used one when it is
+	     * full. */
+	    rc->rc_prog = prog;
+	    rc->rc_had_eol = had_eol;
+	    ++prog->re_refcount;
+	    hash_add(&regcache_ht, rc->rc_key);
+	    regcache_link(rc);
+	    if (++regcache_count > REGCACHE_SIZE)
+		regcache_remove(regcache_last);
+	}
     }
 
     return prog;
@@ -8131,13 +8402,21 @@ vim_regcomp(expr_arg, re_flags)
 
 /*
  * Free a compiled regexp program, returned by vim_regcomp().
+ * The memory is only freed when it isn't used elsewhere.
  */
     void
 vim_regfree(prog)
     regprog_T   *prog;
 {
-    if (prog != NULL)
+    if (prog != NULL && --prog->re_refcount <= 0)
+    {
+	if (prog->re_adapt != NULL)
+	{
+	    vim_regfree(prog->re_adapt->ra_other);
+	    vim_free(prog->re_adapt);
+	}
 	prog->engine->regfree(prog);
+    }
 }
 
 #ifdef FEAT_EVAL
@@ -8157,6 +8436,181 @@ report_re_switch(pat)
 }
 #endif
 
+#ifdef FEAT_RELTIME
+/*
+ * With the automatic engine the NFA engine is used, unless it can't handle
+ * the pattern.  For some patterns the backtracking engine is much faster
+ * though.  The time spent matching is measured for the first REGADAPT_CALLS
+ * calls.  When that took more than REGADAPT_SLOW msec the backtracking engine
+ * is timed for the next REGADAPT_CALLS calls.  If it needed less than half
+ * the time it is used from then on, otherwise the NFA engine is used.
+ */
+# define REGADAPT_CALLS	50
+# define REGADAPT_SLOW	2
+
+# define REGADAPT_LEARN	0	/* timing the NFA engine */
+# define REGADAPT_TRIAL	1	/* timing the backtracking engine */
+# define REGADAPT_NFA	2	/* using the NFA engine */
+# define REGADAPT_BT	3	/* using the backtracking engine */
+
+static long	regadapt_kept = 0;	/* nr of times NFA engine kept */
+static long	regadapt_switched = 0;	/* nr of times switched to backtracking */
+
+static regprog_T *regadapt_prog __ARGS((regprog_T *prog));
+static int regadapt_start __ARGS((regprog_T **progp, proftime_T *start));
+static void regadapt_end __ARGS((regprog_T **progp, regprog_T *prog, int timed, proftime_T *start));
+
+/*
+ * Return the program to use for matching with "prog", which has timing
+ * information: "prog" itself or the same pattern compiled with the
+ * backtracking engine.  Decides what engine to use when enough calls were
+ * timed.
+ */
+    static regprog_T *
+regadapt_prog(prog)
+    regprog_T	*prog;
+{
+    regadapt_T	*ra = prog->re_adapt;
+    proftime_T	tm;
+    proftime_T	now;
+
+    if (ra->ra_state == REGADAPT_LEARN && ra->ra_calls[0] >= REGADAPT_CALLS)
+    {
+	/* "tm" is set to the duration of REGADAPT_SLOW msec. */
+	profile_start(&now);
+	profile_setlimit(REGADAPT_SLOW, &tm);
+	profile_sub(&tm, &now);
+	if (profile_cmp(&ra->ra_time[0], &tm) >= 0)
+	    ra->ra_state = REGADAPT_NFA;
+	else
+	{
+	    int save_p_re = p_re;
+	    int save_had_eol = had_eol;
+	    int save_extmatch = reg_do_extmatch;
+	    int save_rc_did_emsg = rc_did_emsg;
+
+	    /* Allow "\z(" or "\z1" when the pattern was compiled with it.
+	     * The backtracking engine may not accept the pattern, e.g. when
+	     * it is too long.  Don't give an error message then, the NFA
+	     * engine is kept. */
+	    p_re = BACKTRACKING_ENGINE;
+	    reg_do_extmatch = ((nfa_regprog_T *)prog)->reghasz;
+	    ++emsg_off;
+	    ra->ra_other = vim_regcomp(((nfa_regprog_T *)prog)->pattern,
+							       prog->re_flags);
+	    --emsg_off;
+	    p_re = save_p_re;
+	    had_eol = save_had_eol;
+	    reg_do_extmatch = save_extmatch;
+	    rc_did_emsg = save_rc_did_emsg;
+	    ra->ra_state = ra->ra_other == NULL ? REGADAPT_NFA
+							     : REGADAPT_TRIAL;
+	}
+	if (ra->ra_state == REGADAPT_NFA)
+	    ++regadapt_kept;
+    }
+    else if (ra->ra_state == REGADAPT_TRIAL
+				       && ra->ra_calls[1] >= REGADAPT_CALLS)
+    {
+	tm = ra->ra_time[1];
+	profile_add(&tm, &ra->ra_time[1]);
+	if (profile_cmp(&tm, &ra->ra_time[0]) > 0)
+	{
+	    ra->ra_state = REGADAPT_BT;
+	    ++regadapt_switched;
+	}
+	else
+	{
+	    ra->ra_state = REGADAPT_NFA;
+	    ++regadapt_kept;
+	    vim_regfree(ra->ra_other);
+	    ra->ra_other = NULL;
+	}
+    }
+
+    if (ra->ra_state == REGADAPT_TRIAL || ra->ra_state == REGADAPT_BT)
+	return ra->ra_other;
+    return prog;
+}
+
+/*
+ * Called before matching with "*progp".  Sets "*progp" to the program to
+ * execute and starts timing when needed.
+ * Returns TRUE when timing was started.
+ */
+    static int
+regadapt_start(progp, start)
+    regprog_T	**progp;
+    proftime_T	*start;
+{
+    regprog_T	*prog = *progp;
+
+    if (prog->re_adapt == NULL)
+	return FALSE;
+    *progp = regadapt_prog(prog);
+    if (prog->re_adapt->ra_state > REGADAPT_TRIAL)
+	return FALSE;
+    profile_start(start);
+    return TRUE;
+}
+
+/*
+ * Called after matching with the program set by regadapt_start().  Restores
+ * "*progp" to "prog" and adds the time used when "timed" is TRUE.
+ */
+    static void
+regadapt_end(progp, prog, timed, start)
+    regprog_T	**progp;
+    regprog_T	*prog;
+    int		timed;
+    proftime_T	*start;
+{
+    regadapt_T	*ra = prog->re_adapt;
+    int		idx;
+
+    if (ra == NULL)
+	return;
+    *progp = prog;
+    if (timed)
+    {
+	profile_end(start);
+	idx = ra->ra_state == REGADAPT_TRIAL ? 1 : 0;
+	profile_add(&ra->ra_time[idx], start);
+	++ra->ra_calls[idx];
+    }
+}
+
+/*
+ * Show the engine selection for the cached patterns, for ":regexpstats".
+ */
+    static void
+regadapt_stats()
+{
+    regcache_T	*rc;
+    regadapt_T	*ra;
+    char_u	nfa_time[50];
+    static char *(state_names[]) = {N_("timing NFA"),
+		N_("timing backtracking"), N_("using NFA"),
+		N_("using backtracking")};
+
+    smsg((char_u *)_("engine selection: %ld kept NFA, %ld switched to backtracking"),
+					     regadapt_kept, regadapt_switched);
+    for (rc = regcache_first; rc != NULL && !got_int; rc = rc->rc_next)
+    {
+	ra = rc->rc_prog->re_adapt;
+	if (ra == NULL || ra->ra_calls[0] == 0)
+	    continue;
+	STRCPY(nfa_time, profile_msg(&ra->ra_time[0]));
+	smsg((char_u *)_("%s: NFA %d calls %s, backtracking %d calls %s, %s"),
+		((nfa_regprog_T *)rc->rc_prog)->pattern,
+		ra->ra_calls[0], skipwhite(nfa_time),
+		ra->ra_calls[1],
+		skipwhite((char_u *)profile_msg(&ra->ra_time[1])),
+		_(state_names[ra->ra_state]));
+    }
+}
+#endif
+
 static int vim_regexec_both __ARGS((regmatch_T *rmp, char_u *line, colnr_T col, int nl));
 
 /*
@@ -8175,7 +8629,17 @@ vim_regexec_both(rmp, line, col, nl)
     colnr_T	col;    /* column to start looking for match */
     int		nl;
 {
-    int result = rmp->regprog->engine->regexec_nl(rmp, line, col, nl);
+    int		result;
+#ifdef FEAT_RELTIME
+    regprog_T	*prog = rmp->regprog;
+    proftime_T	start;
+    int		timed = regadapt_start(&rmp->regprog, &start);
+#endif
+
+    result = rmp->regprog->engine->regexec_nl(rmp, line, col, nl);
+#ifdef FEAT_RELTIME
+    regadapt_end(&rmp->regprog, prog, timed, &start);
+#endif
 
     /* NFA engine aborted because it's very slow. */
     if (rmp->regprog->re_engine == AUTOMATIC_ENGINE
@@ -8272,8 +8736,18 @@ vim_regexec_multi(rmp, win, buf, lnum, col, tm)
     colnr_T     col;            /* column to start looking for match */
     proftime_T	*tm;		/* timeout limit or NULL */
 {
-    int result = rmp->regprog->engine->regexec_multi(
+    int		result;
+#ifdef FEAT_RELTIME
+    regprog_T	*prog = rmp->regprog;
+    proftime_T	start;
+    int		timed = regadapt_start(&rmp->regprog, &start);
+#endif
+
+    result = rmp->regprog->engine->regexec_multi(
 						rmp, win, buf, lnum, col, tm);
+#ifdef FEAT_RELTIME
+    regadapt_end(&rmp->regprog, prog, timed, &start);
+#endif
 
     /* NFA engine aborted because it's very slow. */
     if (rmp->regprog->re_engine == AUTOMATIC_ENGINE
@@ -8301,3 +8775,29 @@ vim_regexec_multi(rmp, win, buf, lnum, col, tm)
 
     return result <= 0 ? 0 : result;
 }
+
+/*
+ * Return FALSE if vim_regexec_multi() with "rmp" will not find a match that
+ * starts in line "lnum" of buffer "buf", because the line does not contain
+ * the text every match needs.  This is a lot faster than
+ * vim_regexec_multi(), use it to quickly skip lines when looking for a match
+ * in many lines.  When TRUE is returned the line may still not match.
+ */
+    int
+vim_regline_may_match(rmp, buf, lnum)
+    regmmatch_T	*rmp;
+    buf_T	*buf;
+    linenr_T	lnum;
+{
+    regprog_T	*prog = rmp->regprog;
+
+    /* If pattern contains "\c" or "\C": overrule value of rmm_ic */
+    if (prog->regflags & RF_ICASE)
+	ireg_ic = TRUE;
+    else if (prog->regflags & RF_NOICASE)
+	ireg_ic = FALSE;
+    else
+	ireg_ic = rmp->rmm_ic;
+    return prog->engine->regline_may_match(prog,
+					       ml_get_buf(buf, lnum, FALSE));
+}
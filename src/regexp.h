@@ -41,6 +41,19 @@
 
 typedef struct regengine regengine_T;
 
+/*
+ * Timing of a program compiled with the automatic engine, used to find out
+ * whether the backtracking engine is faster for it.  See regadapt_prog().
+ */
+typedef struct
+{
+    int			ra_state;	/* REGADAPT_ values */
+    int			ra_calls[2];	/* nr of timed calls, NFA and
+					   backtracking */
+    proftime_T		ra_time[2];	/* total time of the timed calls */
+    struct regprog	*ra_other;	/* compiled with backtracking engine */
+} regadapt_T;
+
 /*
  * Structure returned by vim_regcomp() to pass on to vim_regexec().
  * This is the general structure. For the actual matcher, two specific
@@ -52,6 +65,9 @@ typedef struct regprog
     unsigned		regflags;
     unsigned		re_engine;   /* automatic, backtracking or nfa engine */
     unsigned		re_flags;    /* second argument for vim_regcomp() */
+    int			re_refcount; /* users of the program, including the
+					cache of compiled patterns */
+    regadapt_T		*re_adapt;   /* timing for automatic engine or NULL */
 } regprog_T;
 
 /*
@@ -61,11 +77,13 @@ typedef struct regprog
  */
 typedef struct
 {
-    /* These four members implement regprog_T */
+    /* These six members implement regprog_T */
     regengine_T		*engine;
     unsigned		regflags;
     unsigned		re_engine;
     unsigned		re_flags;    /* second argument for vim_regcomp() */
+    int			re_refcount;
+    regadapt_T		*re_adapt;
 
     int			regstart;
     char_u		reganch;
@@ -89,31 +107,55 @@ struct nfa_state
     nfa_state_T		*out1;
     int			id;
     int			lastlist[2]; /* 0: normal, 1: recursive */
-    int			val;
+    int			val;	/* for NFA_START_COLL: index in "colls" plus
+				   one, zero if not used */
 };
 
+/*
+ * Precomputed result of matching a collection "[]".
+ */
+typedef struct
+{
+    char_u		cl_bits[2][32];	/* chars below 256, per ireg_ic */
+    int			cl_nranges;	/* nr of pairs in cl_ranges, -1 when
+					   they can't be used */
+    int			*cl_ranges;	/* sorted first and last char of the
+					   ranges for chars 256 and above when
+					   not ignoring case */
+} nfa_coll_T;
+
+/* Lazily built DFA used to check a line quickly, see regexp_nfa.c. */
+typedef struct nfa_dfa nfa_dfa_T;
+
 /*
  * Structure used by the NFA matcher.
  */
 typedef struct
 {
-    /* These three members implement regprog_T */
+    /* These six members implement regprog_T */
     regengine_T		*engine;
     unsigned		regflags;
     unsigned		re_engine;
     unsigned		re_flags;    /* second argument for vim_regcomp() */
+    int			re_refcount;
+    regadapt_T		*re_adapt;
 
     nfa_state_T		*start;		/* points into state[] */
 
     int			reganch;	/* pattern starts with ^ */
     int			regstart;	/* char at start of pattern */
     char_u		*match_text;	/* plain text to match with */
+    char_u		*must_text;	/* text a match must contain */
 
     int			has_zend;	/* pattern contains \ze */
     int			has_backref;	/* pattern contains \1 .. \9 */
 #ifdef FEAT_SYN_HL
     int			reghasz;
 #endif
+    nfa_coll_T		*colls;		/* collections or NULL */
+    int			coll_tick;	/* nfa_coll_tick when "colls" made */
+    int			dfa_possible;	/* a DFA can be used */
+    nfa_dfa_T		*dfa;		/* DFA built so far or NULL */
     char_u		*pattern;
     int			nsubexp;	/* number of () */
     int			nstate;
@@ -167,6 +209,7 @@ struct regengine
     void	(*regfree)(regprog_T *);
     int		(*regexec_nl)(regmatch_T*, char_u*, colnr_T, int);
     long	(*regexec_multi)(regmmatch_T*, win_T*, buf_T*, linenr_T, colnr_T, proftime_T*);
+    int		(*regline_may_match)(regprog_T*, char_u*);
     char_u	*expr;
 };
 
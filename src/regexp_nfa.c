@@ -282,10 +282,30 @@ static int nfa_alt_listid;
 /* 0 for first call to nfa_regmatch(), 1 for recursive call. */
 static int nfa_ll_index = 0;
 
+/* Incremented by regcache_clear() when the locale or 'casemap' changed.  The
+ * collections and the DFA of a program made with another value are built
+ * again, they depend on the character classes and case folding. */
+static int nfa_coll_tick = 0;
+
+/* Return values of nfa_dfa_kind(). */
+#define NFA_DFA_NONE	0	/* cannot be used in a DFA */
+#define NFA_DFA_SKIP	1	/* zero-width, continue with "out" */
+#define NFA_DFA_CHAR	2	/* consumes one character */
+
+/*
+ * Return the state that follows "state" after it matched a character.
+ */
+#define NFA_DFA_OUT(state) ((state)->c == NFA_START_COLL \
+		|| (state)->c == NFA_START_NEG_COLL \
+					    ? (state)->out1->out : (state)->out)
+
 static int nfa_regcomp_start __ARGS((char_u *expr, int re_flags));
 static int nfa_get_reganch __ARGS((nfa_state_T *start, int depth));
 static int nfa_get_regstart __ARGS((nfa_state_T *start, int depth));
 static char_u *nfa_get_match_text __ARGS((nfa_state_T *start));
+static nfa_state_T *nfa_must_next __ARGS((nfa_state_T *p, nfa_state_T *stop, int max));
+static char_u *nfa_get_must_text __ARGS((nfa_regprog_T *prog));
+static int nfa_has_must_text __ARGS((nfa_regprog_T *prog, char_u *s));
 static int realloc_post_list __ARGS((void));
 static int nfa_recognize_char_class __ARGS((char_u *start, char_u *end, int extra_newl));
 static int nfa_emit_equi_class __ARGS((int c));
@@ -308,6 +328,16 @@ static int nfa_max_width __ARGS((nfa_state_T *startstate, int depth));
 static nfa_state_T *post2nfa __ARGS((int *postfix, int *end, int nfa_calc_size));
 static void nfa_postprocess __ARGS((nfa_regprog_T *prog));
 static int check_char_class __ARGS((int class, int c));
+static int
+#ifdef __BORLANDC__
+_RTLENTRYF
+#endif
+nfa_compare_int __ARGS((const void *s1, const void *s2));
+static int nfa_coll_match_slow __ARGS((nfa_state_T *state, int c));
+static int nfa_coll_match __ARGS((nfa_regprog_T *prog, nfa_state_T *state, int c));
+static int nfa_coll_compile __ARGS((nfa_regprog_T *prog));
+static void nfa_coll_free __ARGS((nfa_regprog_T *prog));
+static void nfa_coll_check __ARGS((nfa_regprog_T *prog));
 static void nfa_save_listids __ARGS((nfa_regprog_T *prog, int *list));
 static void nfa_restore_listids __ARGS((nfa_regprog_T *prog, int *list));
 static int nfa_re_num_cmp __ARGS((long_u val, int op, long_u pos));
@@ -317,6 +347,17 @@ static regprog_T *nfa_regcomp __ARGS((char_u *expr, int re_flags));
 static void nfa_regfree __ARGS((regprog_T *prog));
 static int  nfa_regexec_nl __ARGS((regmatch_T *rmp, char_u *line, colnr_T col, int line_lbr));
 static long nfa_regexec_multi __ARGS((regmmatch_T *rmp, win_T *win, buf_T *buf, linenr_T lnum, colnr_T col, proftime_T *tm));
+static int nfa_dfa_kind __ARGS((int c));
+static int nfa_dfa_possible __ARGS((nfa_regprog_T *prog));
+static int nfa_dfa_char_match __ARGS((nfa_regprog_T *prog, nfa_state_T *state, int c));
+static int nfa_dfa_push __ARGS((nfa_regprog_T *prog, nfa_state_T *state, int sp));
+static int nfa_dfa_closure __ARGS((nfa_regprog_T *prog, int sp, int at_bol, int at_eol));
+static int nfa_dfa_state __ARGS((nfa_regprog_T *prog, int len, int bol));
+static int nfa_dfa_next __ARGS((nfa_regprog_T *prog, int from, int c));
+static void nfa_dfa_clear __ARGS((nfa_dfa_T *dfa));
+static void nfa_dfa_free __ARGS((nfa_regprog_T *prog));
+static int nfa_dfa_check __ARGS((nfa_regprog_T *prog, char_u *line));
+static int nfa_regline_may_match __ARGS((regprog_T *prog, char_u *line));
 static int match_follows __ARGS((nfa_state_T *startstate, int depth));
 static int failure_chance __ARGS((nfa_state_T *state, int depth));
 
@@ -560,6 +601,117 @@ nfa_get_match_text(start)
     return ret;
 }
 
+/*
+ * Follow the states from "p" that have only one way to continue, until
+ * reaching "stop", a state with more ways or after "max" states (0 for 50).
+ * Returns the state where it stopped, NULL when "p" has more ways to
+ * continue.
+ */
+    static nfa_state_T *
+nfa_must_next(p, stop, max)
+    nfa_state_T	*p;
+    nfa_state_T	*stop;
+    int		max;
+{
+    int		i;
+
+    for (i = 0; i < (max == 0 ? 50 : max) && p != stop; ++i)
+    {
+	if (p->c > 0 || (p->c >= NFA_ANY && p->c <= NFA_NUPPER_IC)
+		|| p->c == NFA_START_COLL || p->c == NFA_START_NEG_COLL
+		|| p->c == NFA_BOL || p->c == NFA_EOL
+		|| p->c == NFA_BOW || p->c == NFA_EOW
+		|| nfa_dfa_kind(p->c) == NFA_DFA_SKIP)
+	    p = NFA_DFA_OUT(p);
+	else
+	    return NULL;
+    }
+    return p;
+}
+
+/*
+ * Figure out a text that a match must contain: the longest sequence of plain
+ * characters that every match goes through.  It may come from the middle of
+ * the pattern, e.g. "_nosuch" for "\k\+_nosuch".  Only the part of the
+ * pattern before a line break can be matched is used, thus the text is in
+ * the line where the match starts.
+ * Returns NULL when there is no such text or it is just "regstart".
+ */
+    static char_u *
+nfa_get_must_text(prog)
+    nfa_regprog_T   *prog;
+{
+    nfa_state_T	*p = prog->start;
+    char_u	*seen;
+    char_u	*ret = NULL;
+    int		len = 0;
+    garray_T	ga;
+
+    seen = lalloc_clear((long_u)prog->nstate, FALSE);
+    if (seen == NULL)
+	return NULL;
+    ga_init2(&ga, 1, 50);
+    for (;;)
+    {
+	if (seen[p - prog->state])
+	    break;
+	seen[p - prog->state] = TRUE;
+	if (p->c > 0)
+	{
+	    if (ga_grow(&ga, MB_MAXBYTES + 1) == FAIL)
+		break;
+#ifdef FEAT_MBYTE
+	    if (has_mbyte)
+		ga.ga_len += (*mb_char2bytes)(p->c,
+					     (char_u *)ga.ga_data + ga.ga_len);
+	    else
+#endif
+		((char_u *)ga.ga_data)[ga.ga_len++] = p->c;
+	    if (ga.ga_len > len)
+	    {
+		vim_free(ret);
+		ret = vim_strnsave((char_u *)ga.ga_data, ga.ga_len);
+		len = ga.ga_len;
+	    }
+	    p = p->out;
+	}
+	else if (p->c == NFA_BOL || p->c == NFA_EOL || p->c == NFA_BOW
+		|| p->c == NFA_EOW || nfa_dfa_kind(p->c) == NFA_DFA_SKIP)
+	    /* zero-width, the characters before and after are adjacent */
+	    p = p->out;
+	else if (p->c == NFA_SPLIT)
+	{
+	    /* Skip over a loop, e.g. "x*", also used for "x\+".  Give up on
+	     * anything else. */
+	    ga.ga_len = 0;
+	    if (nfa_must_next(p->out, p, 0) == p)
+		p = p->out1;
+	    else if (nfa_must_next(p->out1, p, 0) == p)
+		p = p->out;
+	    else
+		break;
+	}
+	else if (nfa_must_next(p, NULL, 1) != NULL)
+	{
+	    /* matches one character */
+	    ga.ga_len = 0;
+	    p = NFA_DFA_OUT(p);
+	}
+	else
+	    break;
+    }
+    vim_free(seen);
+    ga_clear(&ga);
+
+    if (ret != NULL && prog->regstart != NUL
+	    && PTR2CHAR(ret) == prog->regstart && ret[MB_PTR2LEN(ret)] == NUL)
+    {
+	vim_free(ret);
+	ret = NULL;
+    }
+    return ret;
+}
+
 /*
  * Allocate more space for post_start.  Called when
  * running above the estimated number of states.
@@ -4828,6 +4980,254 @@ check_char_class(class, c)
     return FAIL;
 }
 
+/*
+ * Compare function for qsort() on ints, also used for pairs of ints.
+ */
+    static int
+#ifdef __BORLANDC__
+_RTLENTRYF
+#endif
+nfa_compare_int(s1, s2)
+    const void	*s1;
+    const void	*s2;
+{
+    return *(int *)s1 - *(int *)s2;
+}
+
+/*
+ * Check whether character "c" matches the collection starting at "state", an
+ * NFA_START_COLL or NFA_START_NEG_COLL.  What follows is a list of
+ * characters, until NFA_END_COLL.  One of them must match or none of them
+ * must match.
+ */
+    static int
+nfa_coll_match_slow(state, c)
+    nfa_state_T	*state;
+    int		c;
+{
+    nfa_state_T	*s = state->out;
+    int		result_if_matched = (state->c == NFA_START_COLL);
+    int		c1, c2;
+
+    for (;;)
+    {
+	if (s->c == NFA_END_COLL)
+	    return !result_if_matched;
+	if (s->c == NFA_RANGE_MIN)
+	{
+	    c1 = s->val;
+	    s = s->out; /* advance to NFA_RANGE_MAX */
+	    c2 = s->val;
+	    if (c >= c1 && c <= c2)
+		return result_if_matched;
+	    if (ireg_ic)
+	    {
+		int c_low = MB_TOLOWER(c);
+
+		for ( ; c1 <= c2; ++c1)
+		    if (MB_TOLOWER(c1) == c_low)
+			return result_if_matched;
+	    }
+	}
+	else if (s->c < 0 ? check_char_class(s->c, c)
+		    : (c == s->c
+			|| (ireg_ic && MB_TOLOWER(c) == MB_TOLOWER(s->c))))
+	    return result_if_matched;
+	s = s->out;
+    }
+}
+
+/*
+ * Like nfa_coll_match_slow(), but use the bitmap or the ranges made by
+ * nfa_coll_compile() when possible.
+ */
+    static int
+nfa_coll_match(prog, state, c)
+    nfa_regprog_T   *prog;
+    nfa_state_T	    *state;
+    int		    c;
+{
+    nfa_coll_T	*coll;
+    int		lo, hi, mid;
+
+    if (state->val > 0)
+    {
+	coll = &prog->colls[state->val - 1];
+	if (c < 256)
+	    return (coll->cl_bits[ireg_ic ? 1 : 0][c >> 3] >> (c & 7)) & 1;
+	if (!ireg_ic && coll->cl_nranges >= 0)
+	{
+	    /* binary search for the range that may contain "c" */
+	    lo = 0;
+	    hi = coll->cl_nranges - 1;
+	    while (lo <= hi)
+	    {
+		mid = (lo + hi) / 2;
+		if (c < coll->cl_ranges[mid * 2])
+		    hi = mid - 1;
+		else if (c > coll->cl_ranges[mid * 2 + 1])
+		    lo = mid + 1;
+		else
+		    return state->c == NFA_START_COLL;
+	    }
+	    return state->c != NFA_START_COLL;
+	}
+    }
+    return nfa_coll_match_slow(state, c);
+}
+
+/*
+ * Precompute the result of the collections in "prog" for characters below
+ * 256, for both values of ireg_ic, and the ranges for other characters.
+ * A collection with [:print:] is skipped, it depends on 'isprint'.
+ * Returns FAIL when out of memory.
+ */
+    static int
+nfa_coll_compile(prog)
+    nfa_regprog_T   *prog;
+{
+    nfa_state_T	*state;
+    nfa_state_T	*s;
+    nfa_coll_T	*coll;
+    int		count = 0;
+    int		i, c, ic;
+    int		c1, c2;
+    int		save_ireg_ic = ireg_ic;
+    garray_T	ga;
+
+    prog->coll_tick = nfa_coll_tick;
+    for (i = 0; i < prog->nstate; ++i)
+	if (prog->state[i].c == NFA_START_COLL
+				   || prog->state[i].c == NFA_START_NEG_COLL)
+	    ++count;
+    if (count == 0)
+	return OK;
+    prog->colls = (nfa_coll_T *)alloc_clear(
+					 (unsigned)(count * sizeof(nfa_coll_T)));
+    if (prog->colls == NULL)
+	return FAIL;
+
+    count = 0;
+    for (i = 0; i < prog->nstate; ++i)
+    {
+	state = &prog->state[i];
+	if (state->c != NFA_START_COLL && state->c != NFA_START_NEG_COLL)
+	    continue;
+	for (s = state->out; s->c != NFA_END_COLL; s = s->out)
+	    if (s->c == NFA_CLASS_PRINT)
+		break;
+	if (s->c != NFA_END_COLL)
+	    continue;
+
+	coll = &prog->colls[count++];
+	for (ic = 0; ic <= 1; ++ic)
+	{
+	    ireg_ic = ic;
+	    for (c = 1; c < 256; ++c)
+		if (nfa_coll_match_slow(state, c))
+		    coll->cl_bits[ic][c >> 3] |= 1 << (c & 7);
+	}
+
+	/* Collect the ranges for characters of 256 and above.  The classes
+	 * other than [:lower:] and [:upper:] only match below 256. */
+	ga_init2(&ga, (int)sizeof(int), 20);
+	for (s = state->out; s->c != NFA_END_COLL; s = s->out)
+	{
+	    if (s->c == NFA_RANGE_MIN)
+	    {
+		c1 = s->val;
+		s = s->out;
+		c2 = s->val;
+	    }
+	    else if (s->c >= 0)
+		c1 = c2 = s->c;
+	    else if (s->c == NFA_CLASS_LOWER || s->c == NFA_CLASS_UPPER)
+		break;
+	    else
+		continue;
+	    if (c2 < 256)
+		continue;
+	    if (ga_grow(&ga, 2) == FAIL)
+		break;
+	    ((int *)ga.ga_data)[ga.ga_len++] = c1 < 256 ? 256 : c1;
+	    ((int *)ga.ga_data)[ga.ga_len++] = c2;
+	}
+	if (s->c != NFA_END_COLL)
+	{
+	    ga_clear(&ga);
+	    coll->cl_nranges = -1;
+	}
+	else
+	{
+	    int	    *r = (int *)ga.ga_data;
+	    int	    n = 0;
+
+	    /* Sort on the first char and merge overlapping ranges. */
+	    if (ga.ga_len > 2)
+		qsort((void *)r, (size_t)(ga.ga_len / 2), 2 * sizeof(int),
+							     nfa_compare_int);
+	    for (c = 0; c < ga.ga_len; c += 2)
+	    {
+		if (n > 0 && r[c] <= r[n * 2 - 1] + 1)
+		{
+		    if (r[c + 1] > r[n * 2 - 1])
+			r[n * 2 - 1] = r[c + 1];
+		}
+		else
+		{
+		    r[n * 2] = r[c];
+		    r[n * 2 + 1] = r[c + 1];
+		    ++n;
+		}
+	    }
+	    coll->cl_ranges = r;
+	    coll->cl_nranges = n;
+	}
+	state->val = count;
+    }
+    ireg_ic = save_ireg_ic;
+    return OK;
+}
+
+/*
+ * Free the collections of "prog".
+ */
+    static void
+nfa_coll_free(prog)
+    nfa_regprog_T   *prog;
+{
+    int		i;
+
+    if (prog->colls == NULL)
+	return;
+    for (i = 0; i < prog->nstate; ++i)
+	if (prog->state[i].val > 0
+		&& (prog->state[i].c == NFA_START_COLL
+				  || prog->state[i].c == NFA_START_NEG_COLL))
+	{
+	    vim_free(prog->colls[prog->state[i].val - 1].cl_ranges);
+	    prog->state[i].val = 0;
+	}
+    vim_free(prog->colls);
+    prog->colls = NULL;
+}
+
+/*
+ * When the locale or 'casemap' changed since the collections of "prog" were
+ * made, make them again and clear the DFA, it used the old ones.
+ */
+    static void
+nfa_coll_check(prog)
+    nfa_regprog_T   *prog;
+{
+    if (prog->coll_tick == nfa_coll_tick)
+	return;
+    nfa_coll_free(prog);
+    (void)nfa_coll_compile(prog);	/* when out of memory "colls" is NULL */
+    if (prog->dfa != NULL)
+	nfa_dfa_clear(prog->dfa);
+}
+
 /*
  * Check for a match with subexpression "subidx".
  * Return TRUE if it matches.
@@ -6115,66 +6515,12 @@ nfa_regmatch(prog, start, submatch, m)
 	    case NFA_START_COLL:
 	    case NFA_START_NEG_COLL:
 	      {
-		/* What follows is a list of characters, until NFA_END_COLL.
-		 * One of them must match or none of them must match. */
-		nfa_state_T	*state;
-		int		result_if_matched;
-		int		c1, c2;
-
 		/* Never match EOL. If it's part of the collection it is added
 		 * as a separate state with an OR. */
 		if (curc == NUL)
 		    break;
 
-		state = t->state->out;
-		result_if_matched = (t->state->c == NFA_START_COLL);
-		for (;;)
-		{
-		    if (state->c == NFA_END_COLL)
-		    {
-			result = !result_if_matched;
-			break;
-		    }
-		    if (state->c == NFA_RANGE_MIN)
-		    {
-			c1 = state->val;
-			state = state->out; /* advance to NFA_RANGE_MAX */
-			c2 = state->val;
-#ifdef ENABLE_LOG
-			fprintf(log_fd, "NFA_RANGE_MIN curc=%d c1=%d c2=%d\n",
-				curc, c1, c2);
-#endif
-			if (curc >= c1 && curc <= c2)
-			{
-			    result = result_if_matched;
-			    break;
-			}
-			if (ireg_ic)
-			{
-			    int curc_low = MB_TOLOWER(curc);
-			    int done = FALSE;
-
-			    for ( ; c1 <= c2; ++c1)
-				if (MB_TOLOWER(c1) == curc_low)
-				{
-				    result = result_if_matched;
-				    done = TRUE;
-				    break;
-				}
-			    if (done)
-				break;
-			}
-		    }
-		    else if (state->c < 0 ? check_char_class(state->c, curc)
-			        : (curc == state->c
-				   || (ireg_ic && MB_TOLOWER(curc)
-						    == MB_TOLOWER(state->c))))
-		    {
-			result = result_if_matched;
-			break;
-		    }
-		    state = state->out;
-		}
+		result = nfa_coll_match(prog, t->state, curc);
 		if (result)
 		{
 		    /* next state is in out of the NFA_END_COLL, out1 of
@@ -7028,6 +7374,8 @@ nfa_regexec_both(line, startcol, tm)
 	ireg_icombine = TRUE;
 #endif
 
+    nfa_coll_check(prog);
+
     regline = line;
     reglnum = 0;    /* relative to line */
 
@@ -7041,6 +7389,12 @@ nfa_regexec_both(line, startcol, tm)
     if (prog->reganch && col > 0)
 	return 0L;
 
+    /* When matching a whole string check with the DFA whether it can match
+     * at all. */
+    if (!REG_MULTI && col == 0 && !reg_line_lbr && prog->dfa_possible
+					       && !nfa_dfa_check(prog, line))
+	return 0L;
+
     need_clear_subexpr = TRUE;
 #ifdef FEAT_SYN_HL
     /* Clear the external match subpointers if necessary. */
@@ -7070,6 +7424,10 @@ nfa_regexec_both(line, startcol, tm)
 	    return find_match_text(col, prog->regstart, prog->match_text);
     }
 
+    /* A match must contain "must_text", no need to try when it's missing. */
+    if (!nfa_has_must_text(prog, regline + col))
+	return 0L;
+
     /* If the start column is past the maximum column: no need to try. */
     if (ireg_maxcol > 0 && col >= ireg_maxcol)
 	goto theend;
@@ -7171,10 +7529,15 @@ nfa_regcomp(expr, re_flags)
     prog->nsubexp = regnpar;
 
     nfa_postprocess(prog);
+    prog->colls = NULL;
+    if (nfa_coll_compile(prog) == FAIL)
+	goto fail;
 
     prog->reganch = nfa_get_reganch(prog->start, 0);
     prog->regstart = nfa_get_regstart(prog->start, 0);
     prog->match_text = nfa_get_match_text(prog->start);
+    prog->must_text = prog->match_text != NULL ? NULL
+						: nfa_get_must_text(prog);
 
 #ifdef ENABLE_LOG
     nfa_postfix_dump(expr, OK);
@@ -7184,6 +7547,8 @@ nfa_regcomp(expr, re_flags)
     /* Remember whether this pattern has any \z specials in it. */
     prog->reghasz = re_has_z;
 #endif
+    prog->dfa = NULL;
+    prog->dfa_possible = nfa_dfa_possible(prog);
     prog->pattern = vim_strsave(expr);
     nfa_regengine.expr = NULL;
 
@@ -7212,7 +7577,10 @@ nfa_regfree(prog)
 {
     if (prog != NULL)
     {
+	nfa_dfa_free((nfa_regprog_T *)prog);
+	nfa_coll_free((nfa_regprog_T *)prog);
 	vim_free(((nfa_regprog_T *)prog)->match_text);
+	vim_free(((nfa_regprog_T *)prog)->must_text);
 	vim_free(((nfa_regprog_T *)prog)->pattern);
 	vim_free(prog);
     }
@@ -7298,6 +7666,543 @@ nfa_regexec_multi(rmp, win, buf, lnum, col, tm)
     return nfa_regexec_both(NULL, col, tm);
 }
 
+/*
+ * A pattern that only matches inside one line and consists of plain
+ * characters, character classes, collections, "^" and "$" can be checked
+ * with a DFA.  Each DFA state is a set of NFA states.  The DFA is built lazily:
+ * a transition is only computed the first time it is used, and only for ASCII
+ * characters.  A line containing other bytes is left to the NFA.  The DFA only
+ * tells whether the line contains a match, it does not find the position or
+ * submatches.
+ */
+#define NFA_DFA_MAXSTATES   256	/* flush the DFA when it gets bigger */
+#define NFA_DFA_MAXFLUSH    8	/* give up after flushing this many times */
+#define NFA_DFA_UNKNOWN	    -1	/* transition not computed yet */
+
+typedef struct
+{
+    int		*ds_ids;	/* sorted indexes of the NFA states */
+    int		ds_len;		/* number of items in ds_ids */
+    int		ds_bol;		/* state at the start of the line */
+    int		ds_match;	/* contains NFA_MATCH */
+    int		ds_match_eol;	/* matches at the end of the line */
+    short	ds_next[128];	/* next state for each ASCII character */
+} nfa_dstate_T;
+
+struct nfa_dfa
+{
+    int		ireg_ic;	/* value of ireg_ic the DFA was built with */
+    int		flushed;	/* number of times the DFA was flushed */
+    garray_T	states;		/* nfa_dstate_T items */
+    int		gen;		/* incremented for every closure */
+    int		*mark;		/* per NFA state: "gen" when pushed */
+    nfa_state_T	**stack;	/* NFA states to add to the closure */
+    int		*ids;		/* result of nfa_dfa_closure() */
+};
+
+/*
+ * Return how the NFA state type "c" is handled by the DFA.
+ */
+    static int
+nfa_dfa_kind(c)
+    int		c;
+{
+    if (c >= 0)
+	return NFA_DFA_CHAR;
+    if ((c >= NFA_MOPEN && c <= NFA_MOPEN9)
+	    || (c >= NFA_MCLOSE && c <= NFA_MCLOSE9))
+	return NFA_DFA_SKIP;
+    switch (c)
+    {
+	case NFA_EMPTY:
+	case NFA_NOPEN:
+	case NFA_NCLOSE:
+	case NFA_ZSTART:
+	case NFA_ZEND:
+	    return NFA_DFA_SKIP;
+
+	case NFA_ANY:
+	case NFA_START_COLL:
+	case NFA_START_NEG_COLL:
+	case NFA_WHITE:
+	case NFA_NWHITE:
+	case NFA_DIGIT:
+	case NFA_NDIGIT:
+	case NFA_HEX:
+	case NFA_NHEX:
+	case NFA_OCTAL:
+	case NFA_NOCTAL:
+	case NFA_WORD:
+	case NFA_NWORD:
+	case NFA_HEAD:
+	case NFA_NHEAD:
+	case NFA_ALPHA:
+	case NFA_NALPHA:
+	case NFA_LOWER:
+	case NFA_NLOWER:
+	case NFA_UPPER:
+	case NFA_NUPPER:
+	case NFA_LOWER_IC:
+	case NFA_NLOWER_IC:
+	case NFA_UPPER_IC:
+	case NFA_NUPPER_IC:
+	    return NFA_DFA_CHAR;
+    }
+    /* Anything else depends on more than the current character or on
+     * options that may change. */
+    return NFA_DFA_NONE;
+}
+
+/*
+ * Return TRUE if all states of "prog" that can be reached can be handled by
+ * a DFA.
+ */
+    static int
+nfa_dfa_possible(prog)
+    nfa_regprog_T   *prog;
+{
+    char_u	*seen;
+    nfa_state_T	**stack;
+    nfa_state_T	*state;
+    int		sp = 0;
+    int		ok = TRUE;
+
+    if (prog->has_backref
+#ifdef FEAT_SYN_HL
+	    || prog->reghasz == REX_SET
+#endif
+	    )
+	return FALSE;
+    seen = lalloc_clear((long_u)prog->nstate, FALSE);
+    stack = (nfa_state_T **)lalloc(
+		     (long_u)(prog->nstate * sizeof(nfa_state_T *)), FALSE);
+    if (seen == NULL || stack == NULL)
+	ok = FALSE;
+    else
+    {
+	stack[sp++] = prog->start;
+	seen[prog->start - prog->state] = TRUE;
+    }
+    while (ok && sp > 0)
+    {
+	state = stack[--sp];
+	switch (state->c)
+	{
+	    case NFA_MATCH:
+		continue;
+	    case NFA_SPLIT:
+		if (!seen[state->out1 - prog->state])
+		{
+		    seen[state->out1 - prog->state] = TRUE;
+		    stack[sp++] = state->out1;
+		}
+		/* FALLTHROUGH */
+	    case NFA_BOL:
+	    case NFA_EOL:
+		break;
+	    default:
+		if (nfa_dfa_kind(state->c) == NFA_DFA_NONE)
+		{
+		    ok = FALSE;
+		    continue;
+		}
+		state = NFA_DFA_OUT(state);
+		if (!seen[state - prog->state])
+		{
+		    seen[state - prog->state] = TRUE;
+		    stack[sp++] = state;
+		}
+		continue;
+	}
+	if (!seen[state->out - prog->state])
+	{
+	    seen[state->out - prog->state] = TRUE;
+	    stack[sp++] = state->out;
+	}
+    }
+    vim_free(seen);
+    vim_free(stack);
+    return ok;
+}
+
+/*
+ * Return TRUE if the character consuming NFA "state" matches character "c".
+ * This must do the same as nfa_regmatch().
+ */
+    static int
+nfa_dfa_char_match(prog, state, c)
+    nfa_regprog_T   *prog;
+    nfa_state_T	    *state;
+    int		    c;
+{
+    switch (state->c)
+    {
+	case NFA_ANY:	    return TRUE;
+	case NFA_WHITE:	    return vim_iswhite(c);
+	case NFA_NWHITE:    return !vim_iswhite(c);
+	case NFA_DIGIT:	    return ri_digit(c);
+	case NFA_NDIGIT:    return !ri_digit(c);
+	case NFA_HEX:	    return ri_hex(c);
+	case NFA_NHEX:	    return !ri_hex(c);
+	case NFA_OCTAL:	    return ri_octal(c);
+	case NFA_NOCTAL:    return !ri_octal(c);
+	case NFA_WORD:	    return ri_word(c);
+	case NFA_NWORD:	    return !ri_word(c);
+	case NFA_HEAD:	    return ri_head(c);
+	case NFA_NHEAD:	    return !ri_head(c);
+	case NFA_ALPHA:	    return ri_alpha(c);
+	case NFA_NALPHA:    return !ri_alpha(c);
+	case NFA_LOWER:	    return ri_lower(c);
+	case NFA_NLOWER:    return !ri_lower(c);
+	case NFA_UPPER:	    return ri_upper(c);
+	case NFA_NUPPER:    return !ri_upper(c);
+	case NFA_LOWER_IC:  return ri_lower(c) || (ireg_ic && ri_upper(c));
+	case NFA_NLOWER_IC: return !(ri_lower(c) || (ireg_ic && ri_upper(c)));
+	case NFA_UPPER_IC:  return ri_upper(c) || (ireg_ic && ri_lower(c));
+	case NFA_NUPPER_IC: return !(ri_upper(c) || (ireg_ic && ri_lower(c)));
+
+	case NFA_START_COLL:
+	case NFA_START_NEG_COLL:
+	    return nfa_coll_match(prog, state, c);
+    }
+
+    /* regular character */
+    return c == state->c
+		  || (ireg_ic && MB_TOLOWER(state->c) == MB_TOLOWER(c));
+}
+
+/*
+ * Put "state" on the closure stack of "dfa", unless it was already added.
+ * Returns the new stack size.
+ */
+    static int
+nfa_dfa_push(prog, state, sp)
+    nfa_regprog_T   *prog;
+    nfa_state_T	    *state;
+    int		    sp;
+{
+    nfa_dfa_T	*dfa = prog->dfa;
+    int		idx = (int)(state - prog->state);
+
+    if (dfa->mark[idx] == dfa->gen)
+	return sp;
+    dfa->mark[idx] = dfa->gen;
+    dfa->stack[sp] = state;
+    return sp + 1;
+}
+
+/*
+ * Follow the zero-width states of the "sp" states on the stack of the DFA of
+ * "prog".  "^" matches when "at_bol" is TRUE, "$" when "at_eol" is TRUE.
+ * The resulting set is stored in dfa->ids, sorted.
+ * Returns the number of NFA states in the set.
+ */
+    static int
+nfa_dfa_closure(prog, sp, at_bol, at_eol)
+    nfa_regprog_T   *prog;
+    int		    sp;
+    int		    at_bol;
+    int		    at_eol;
+{
+    nfa_dfa_T	*dfa = prog->dfa;
+    nfa_state_T	*state;
+    int		len = 0;
+
+    while (sp > 0)
+    {
+	state = dfa->stack[--sp];
+	switch (state->c)
+	{
+	    case NFA_SPLIT:
+		sp = nfa_dfa_push(prog, state->out1, sp);
+		sp = nfa_dfa_push(prog, state->out, sp);
+		break;
+
+	    case NFA_BOL:
+		if (at_bol)
+		    sp = nfa_dfa_push(prog, state->out, sp);
+		break;
+
+	    case NFA_EOL:
+		if (at_eol)
+		    sp = nfa_dfa_push(prog, state->out, sp);
+		else
+		    dfa->ids[len++] = (int)(state - prog->state);
+		break;
+
+	    default:
+		if (state->c != NFA_MATCH
+			&& nfa_dfa_kind(state->c) == NFA_DFA_SKIP)
+		    sp = nfa_dfa_push(prog, state->out, sp);
+		else
+		    dfa->ids[len++] = (int)(state - prog->state);
+		break;
+	}
+    }
+    qsort((void *)dfa->ids, (size_t)len, sizeof(int), nfa_compare_int);
+    return len;
+}
+
+/*
+ * Find the DFA state for the set of "len" NFA states in dfa->ids, add it when
+ * it does not exist yet.  "bol" is TRUE for the state at the start of the
+ * line.
+ * Returns the index of the DFA state, -1 when there are too many.
+ */
+    static int
+nfa_dfa_state(prog, len, bol)
+    nfa_regprog_T   *prog;
+    int		    len;
+    int		    bol;
+{
+    nfa_dfa_T	    *dfa = prog->dfa;
+    nfa_dstate_T    *ds;
+    int		    i;
+    int		    sp = 0;
+
+    for (i = 0; i < dfa->states.ga_len; ++i)
+    {
+	ds = ((nfa_dstate_T *)dfa->states.ga_data) + i;
+	if (ds->ds_len == len && ds->ds_bol == bol
+		&& memcmp(ds->ds_ids, dfa->ids, len * sizeof(int)) == 0)
+	    return i;
+    }
+
+    if (dfa->states.ga_len >= NFA_DFA_MAXSTATES
+					  || ga_grow(&dfa->states, 1) == FAIL)
+	return -1;
+    ds = ((nfa_dstate_T *)dfa->states.ga_data) + dfa->states.ga_len;
+    ds->ds_ids = (int *)alloc((unsigned)((len + 1) * sizeof(int)));
+    if (ds->ds_ids == NULL)
+	return -1;
+    mch_memmove(ds->ds_ids, dfa->ids, len * sizeof(int));
+    ds->ds_len = len;
+    ds->ds_bol = bol;
+    ds->ds_match = FALSE;
+    for (i = 0; i < 128; ++i)
+	ds->ds_next[i] = NFA_DFA_UNKNOWN;
+
+    /* Find out whether there is a match, or whether there is one when "$"
+     * matches. */
+    ++dfa->gen;
+    for (i = 0; i < len; ++i)
+    {
+	nfa_state_T *state = &prog->state[ds->ds_ids[i]];
+
+	if (state->c == NFA_MATCH)
+	    ds->ds_match = TRUE;
+	else if (state->c == NFA_EOL)
+	    sp = nfa_dfa_push(prog, state->out, sp);
+    }
+    ds->ds_match_eol = ds->ds_match;
+    if (!ds->ds_match && sp > 0)
+    {
+	len = nfa_dfa_closure(prog, sp, bol, TRUE);
+	for (i = 0; i < len; ++i)
+	    if (prog->state[dfa->ids[i]].c == NFA_MATCH)
+		ds->ds_match_eol = TRUE;
+    }
+
+    return dfa->states.ga_len++;
+}
+
+/*
+ * Compute the transition from DFA state "from" for character "c".
+ * Returns the index of the new DFA state, -1 when there are too many.
+ */
+    static int
+nfa_dfa_next(prog, from, c)
+    nfa_regprog_T   *prog;
+    int		    from;
+    int		    c;
+{
+    nfa_dfa_T	    *dfa = prog->dfa;
+    nfa_dstate_T    *ds = ((nfa_dstate_T *)dfa->states.ga_data) + from;
+    nfa_state_T	    *state;
+    int		    sp = 0;
+    int		    i;
+    int		    to;
+
+    ++dfa->gen;
+    for (i = 0; i < ds->ds_len; ++i)
+    {
+	state = &prog->state[ds->ds_ids[i]];
+	if (state->c != NFA_MATCH && state->c != NFA_EOL
+				     && nfa_dfa_char_match(prog, state, c))
+	    sp = nfa_dfa_push(prog, NFA_DFA_OUT(state), sp);
+    }
+    /* A match may also start at the next character. */
+    sp = nfa_dfa_push(prog, prog->start, sp);
+
+    to = nfa_dfa_state(prog, nfa_dfa_closure(prog, sp, FALSE, FALSE), FALSE);
+    if (to >= 0)
+	((nfa_dstate_T *)dfa->states.ga_data)[from].ds_next[c] = to;
+    return to;
+}
+
+/*
+ * Free the states of "dfa", so that it can be built again.
+ */
+    static void
+nfa_dfa_clear(dfa)
+    nfa_dfa_T	*dfa;
+{
+    int		i;
+
+    for (i = 0; i < dfa->states.ga_len; ++i)
+	vim_free(((nfa_dstate_T *)dfa->states.ga_data)[i].ds_ids);
+    ga_clear(&dfa->states);
+}
+
+/*
+ * Free the DFA of "prog".
+ */
+    static void
+nfa_dfa_free(prog)
+    nfa_regprog_T   *prog;
+{
+    nfa_dfa_T	*dfa = prog->dfa;
+
+    if (dfa != NULL)
+    {
+	nfa_dfa_clear(dfa);
+	vim_free(dfa->mark);
+	vim_free(dfa->stack);
+	vim_free(dfa->ids);
+	vim_free(dfa);
+	prog->dfa = NULL;
+    }
+}
+
+/*
+ * Use a DFA to check whether "line" contains a match for "prog".  Uses
+ * "ireg_ic".
+ * Returns FALSE when there is no match, TRUE when there is a match or it is
+ * unknown.
+ */
+    static int
+nfa_dfa_check(prog, line)
+    nfa_regprog_T   *prog;
+    char_u	    *line;
+{
+    nfa_dfa_T	    *dfa = prog->dfa;
+    nfa_dstate_T    *ds;
+    char_u	    *p;
+    int		    s;
+
+    if (dfa == NULL)
+    {
+	dfa = (nfa_dfa_T *)alloc_clear((unsigned)sizeof(nfa_dfa_T));
+	if (dfa == NULL)
+	    return TRUE;
+	prog->dfa = dfa;
+	ga_init2(&dfa->states, (int)sizeof(nfa_dstate_T), 16);
+	dfa->mark = (int *)alloc_clear(
+				    (unsigned)(prog->nstate * sizeof(int)));
+	dfa->stack = (nfa_state_T **)alloc(
+			    (unsigned)(prog->nstate * sizeof(nfa_state_T *)));
+	dfa->ids = (int *)alloc((unsigned)(prog->nstate * sizeof(int)));
+	if (dfa->mark == NULL || dfa->stack == NULL || dfa->ids == NULL)
+	{
+	    nfa_dfa_free(prog);
+	    prog->dfa_possible = FALSE;
+	    return TRUE;
+	}
+	dfa->ireg_ic = ireg_ic;
+    }
+    else if (dfa->ireg_ic != ireg_ic)
+    {
+	/* Transitions depend on 'ignorecase'. */
+	nfa_dfa_clear(dfa);
+	dfa->ireg_ic = ireg_ic;
+    }
+
+    if (dfa->states.ga_len == 0)
+    {
+	++dfa->gen;
+	if (nfa_dfa_state(prog, nfa_dfa_closure(prog,
+			 nfa_dfa_push(prog, prog->start, 0), TRUE, FALSE),
+								 TRUE) < 0)
+	    return TRUE;
+    }
+
+    s = 0;
+    for (p = line; ; ++p)
+    {
+	ds = ((nfa_dstate_T *)dfa->states.ga_data) + s;
+	if (ds->ds_match)
+	    return TRUE;
+	if (*p == NUL)
+	    return ds->ds_match_eol;
+	if (*p >= 0x80)
+	    return TRUE;
+	s = ds->ds_next[*p];
+	if (s == NFA_DFA_UNKNOWN)
+	{
+	    s = nfa_dfa_next(prog, (int)(ds
+			       - (nfa_dstate_T *)dfa->states.ga_data), *p);
+	    if (s < 0)
+	    {
+		/* Too many states, start again with the next line.  Give up
+		 * when this keeps happening. */
+		if (++dfa->flushed > NFA_DFA_MAXFLUSH)
+		{
+		    nfa_dfa_free(prog);
+		    prog->dfa_possible = FALSE;
+		}
+		else
+		    nfa_dfa_clear(dfa);
+		return TRUE;
+	    }
+	}
+    }
+}
+
+/*
+ * Return FALSE if "s" does not contain the "must_text" of "prog".  Also
+ * returns TRUE when this can't be checked, because ignoring case or combining
+ * characters makes the bytes differ.  Uses "ireg_ic".
+ */
+    static int
+nfa_has_must_text(prog, s)
+    nfa_regprog_T   *prog;
+    char_u	    *s;
+{
+    int		len;
+
+    if (prog->must_text == NULL)
+	return TRUE;
+#ifdef FEAT_MBYTE
+    if ((prog->regflags & RF_ICOMBINE) || (ireg_ic && has_mbyte))
+	return TRUE;
+#endif
+    len = (int)STRLEN(prog->must_text);
+    return find_regmust(s, prog->must_text, &len) != NULL;
+}
+
+/*
+ * Return FALSE if nfa_regexec_multi() will not find a match starting in
+ * "line", because it does not contain the character the match starts with or
+ * the text a match must contain, or the DFA finds no match.
+ * Uses "ireg_ic".
+ */
+    static int
+nfa_regline_may_match(prog_arg, line)
+    regprog_T	*prog_arg;
+    char_u	*line;
+{
+    nfa_regprog_T *prog = (nfa_regprog_T *)prog_arg;
+
+    if (prog->regstart != NUL && cstrchr(line, prog->regstart) == NULL)
+	return FALSE;
+    if (!nfa_has_must_text(prog, line))
+	return FALSE;
+    if (!prog->dfa_possible)
+	return TRUE;
+    nfa_coll_check(prog);
+    return nfa_dfa_check(prog, line);
+}
+
 #ifdef DEBUG
 # undef ENABLE_LOG
 #endif
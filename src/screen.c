@@ -125,6 +125,9 @@ static void fill_foldcolumn __ARGS((char_u *p, win_T *wp, int closed, linenr_T l
 static void copy_text_attr __ARGS((int off, char_u *buf, int len, int attr));
 #endif
 static int win_line __ARGS((win_T *, linenr_T, int, int, int nochange));
+static int linecache_usable __ARGS((win_T *wp, linenr_T lnum));
+static int linecache_draw __ARGS((win_T *wp, linenr_T lnum, int row));
+static void linecache_store __ARGS((win_T *wp, linenr_T lnum, int row));
 static int char_needs_redraw __ARGS((int off_from, int off_to, int cols));
 #ifdef FEAT_RIGHTLEFT
 static void screen_line __ARGS((int row, int coloff, int endcol, int clear_width, int rlflag));
@@ -419,8 +422,8 @@ redraw_asap(type)
  * requires that line and possibly other lines to be redrawn.
  * Used when entering/leaving Insert mode with the cursor on a folded line.
  * Used to remove the "$" from a change command.
- * Note that when also inserting/deleting lines w_redraw_top and w_redraw_bot
- * may become invalid and the whole window will have to be redrawn.
+ * When inserting/deleting lines changed_common() adjusts w_redraw_top and
+ * w_redraw_bot.
  */
     void
 redrawWinline(lnum, invalid)
@@ -507,6 +510,7 @@ update_screen(type)
     }
 
     updating_screen = TRUE;
+    term_start_frame();
 #ifdef FEAT_SYN_HL
     ++display_tick;	    /* let syntax code know we're in a next round of
 			     * display updating */
@@ -719,6 +723,7 @@ update_screen(type)
     if (!did_intro)
 	maybe_intro_message();
     did_intro = TRUE;
+    term_end_frame();
 
 #ifdef FEAT_GUI
     /* Redraw the cursor and update the scrollbars when all screen updating is
@@ -1057,6 +1062,7 @@ win_update(wp)
     int		did_update = DID_NONE;
     linenr_T	syntax_last_parsed = 0;		/* last parsed text line */
 #endif
+    int		use_linecache;
     linenr_T	mod_top = 0;
     linenr_T	mod_bot = 0;
 #if defined(FEAT_SYN_HL) || defined(FEAT_SEARCH_EXTRA)
@@ -1106,17 +1112,6 @@ win_update(wp)
     }
     else
 #endif
-
-    if (buf->b_mod_set && buf->b_mod_xlines != 0 && wp->w_redraw_top != 0)
-    {
-	/*
-	 * When there are both inserted/deleted lines and specific lines to be
-	 * redrawn, w_redraw_top and w_redraw_bot may be invalid, just redraw
-	 * everything (only happens when redrawing is off for while).
-	 */
-	type = NOT_VALID;
-    }
-    else
     {
 	/*
 	 * Set mod_top to the first line that needs displaying because of
@@ -1783,6 +1778,9 @@ win_update(wp)
 				|| (wp->w_match_head != NULL
 						    && buf->b_mod_xlines != 0)
 #endif
+				/* relative numbers change for lines below
+				 * inserted or deleted lines */
+				|| (wp->w_p_rnu && buf->b_mod_xlines != 0)
 				)))))
 	{
 #ifdef FEAT_SEARCH_EXTRA
@@ -2006,9 +2004,22 @@ win_update(wp)
 #endif
 
 		/*
-		 * Display one line.
+		 * Display one line.  Use the screen cells from the last time
+		 * it was drawn when possible.
 		 */
-		row = win_line(wp, lnum, srow, wp->w_height, mod_top == 0);
+		use_linecache = linecache_usable(wp, lnum);
+		if (use_linecache && linecache_draw(wp, lnum, srow))
+		    row = srow + 1;
+		else
+		{
+		    row = win_line(wp, lnum, srow, wp->w_height, mod_top == 0);
+		    ++redraw_line_count;
+		    if (use_linecache && row == srow + 1)
+			linecache_store(wp, lnum, srow);
+#ifdef FEAT_SYN_HL
+		    syntax_last_parsed = lnum;
+#endif
+		}
 
 #ifdef FEAT_FOLDING
 		wp->w_lines[idx].wl_folded = FALSE;
@@ -2016,7 +2027,6 @@ win_update(wp)
 #endif
 #ifdef FEAT_SYN_HL
 		did_update = DID_LINE;
-		syntax_last_parsed = lnum;
 #endif
 	    }
 
@@ -2220,6 +2230,210 @@ draw_signcolumn(wp)
 }
 #endif
 
+/*
+ * Return TRUE when line "lnum" in window "wp" may be drawn from, and stored
+ * in, w_linecache.  Not when the line is drawn differently depending on the
+ * cursor position, Visual mode, matches or anything else that is not part of
+ * the cache key.
+ */
+    static int
+linecache_usable(wp, lnum)
+    win_T	*wp;
+    linenr_T	lnum;
+{
+    if (lnum == wp->w_cursor.lnum
+	    || dollar_vcol >= 0
+	    || (lnum == wp->w_topline && wp->w_skipcol > 0)
+#ifdef FEAT_MBYTE
+	    || enc_dbcs != 0
+#endif
+#ifdef FEAT_VISUAL
+	    || (VIsual_active && wp->w_buffer == curwin->w_buffer)
+#endif
+#ifdef FEAT_RIGHTLEFT
+	    || wp->w_p_rl
+#endif
+	    || wp->w_p_rnu
+#ifdef FEAT_SYN_HL
+	    || wp->w_p_cuc
+	    || syntax_uses_cursor(wp)
+#endif
+#ifdef FEAT_SPELL
+	    || wp->w_p_spell
+#endif
+#ifdef FEAT_CONCEAL
+	    || wp->w_p_cole > 0
+#endif
+#ifdef FEAT_DIFF
+	    || wp->w_p_diff
+#endif
+#ifdef FEAT_FOLDING
+	    || wp->w_p_fdc > 0
+#endif
+#ifdef FEAT_SIGNS
+	    || draw_signcolumn(wp)
+#endif
+#ifdef FEAT_SEARCH_EXTRA
+	    || search_hl.rm.regprog != NULL
+	    || wp->w_match_head != NULL
+#endif
+	    || highlight_match)
+	return FALSE;
+    return TRUE;
+}
+
+/*
+ * Draw line "lnum" of window "wp" in screen row "row" (relative to the
+ * window) from w_linecache.
+ * Return FALSE when the line is not in the cache or the entry is outdated.
+ */
+    static int
+linecache_draw(wp, lnum, row)
+    win_T	*wp;
+    linenr_T	lnum;
+    int		row;
+{
+    linecache_T	*lc;
+    int		width = W_WIDTH(wp);
+    int		i;
+
+    if (wp->w_linecache == NULL)
+	return FALSE;
+    lc = &wp->w_linecache[lnum % LINECACHE_SIZE];
+    if (lc->lc_lnum != lnum
+	    || lc->lc_fnum != wp->w_buffer->b_fnum
+	    || lc->lc_changedtick != wp->w_buffer->b_changedtick
+	    || lc->lc_tick != linecache_tick
+	    || lc->lc_leftcol != wp->w_leftcol
+	    || lc->lc_width != width)
+	return FALSE;
+
+    mch_memmove(current_ScreenLine, lc->lc_chars,
+					       (size_t)width * sizeof(schar_T));
+    mch_memmove(ScreenAttrs + (current_ScreenLine - ScreenLines),
+			       lc->lc_attrs, (size_t)width * sizeof(sattr_T));
+#ifdef FEAT_MBYTE
+    if (enc_utf8)
+    {
+	i = (int)(current_ScreenLine - ScreenLines);
+	mch_memmove(ScreenLinesUC + i, lc->lc_uc,
+					      (size_t)width * sizeof(u8char_T));
+	for ( ; i < (current_ScreenLine - ScreenLines) + width; ++i)
+	    ScreenLinesC[0][i] = 0;
+    }
+#endif
+    SCREEN_LINE(W_WINROW(wp) + row, W_WINCOL(wp), width, width, FALSE);
+    return TRUE;
+}
+
+/*
+ * Store the screen cells of line "lnum" of window "wp", just drawn in screen
+ * row "row" (relative to the window), in w_linecache.
+ */
+    static void
+linecache_store(wp, lnum, row)
+    win_T	*wp;
+    linenr_T	lnum;
+    int		row;
+{
+    linecache_T	*lc;
+    int		width = W_WIDTH(wp);
+    unsigned	off = LineOffset[W_WINROW(wp) + row] + W_WINCOL(wp);
+    int		i;
+
+    if (got_int)
+	return;
+    for (i = 0; i < width; ++i)
+    {
+	/* A cell that is not drawn yet or that has composing characters
+	 * can't be stored. */
+	if (ScreenAttrs[off + i] == (sattr_T)-1
+#ifdef FEAT_MBYTE
+		|| (enc_utf8 && ScreenLinesUC[off + i] != 0
+					     && ScreenLinesC[0][off + i] != 0)
+#endif
+		)
+	    return;
+    }
+
+    if (wp->w_linecache == NULL)
+    {
+	wp->w_linecache = (linecache_T *)alloc_clear((unsigned)
+				       (LINECACHE_SIZE * sizeof(linecache_T)));
+	if (wp->w_linecache == NULL)
+	    return;
+    }
+    lc = &wp->w_linecache[lnum % LINECACHE_SIZE];
+    if (lc->lc_chars == NULL || lc->lc_width != width)
+    {
+	vim_free(lc->lc_chars);
+	vim_free(lc->lc_attrs);
+	lc->lc_attrs = NULL;
+#ifdef FEAT_MBYTE
+	vim_free(lc->lc_uc);
+	lc->lc_uc = NULL;
+#endif
+	lc->lc_lnum = 0;
+	lc->lc_chars = (schar_T *)alloc((unsigned)(width * sizeof(schar_T)));
+	lc->lc_attrs = (sattr_T *)alloc((unsigned)(width * sizeof(sattr_T)));
+#ifdef FEAT_MBYTE
+	lc->lc_uc = (u8char_T *)alloc((unsigned)(width * sizeof(u8char_T)));
+	if (lc->lc_uc == NULL)
+	{
+	    vim_free(lc->lc_attrs);
+	    lc->lc_attrs = NULL;
+	}
+#endif
+	if (lc->lc_chars == NULL || lc->lc_attrs == NULL)
+	{
+	    vim_free(lc->lc_chars);
+	    vim_free(lc->lc_attrs);
+	    lc->lc_chars = NULL;
+	    lc->lc_attrs = NULL;
+	    return;
+	}
+    }
+
+    mch_memmove(lc->lc_chars, ScreenLines + off,
+					       (size_t)width * sizeof(schar_T));
+    mch_memmove(lc->lc_attrs, ScreenAttrs + off,
+					       (size_t)width * sizeof(sattr_T));
+#ifdef FEAT_MBYTE
+    if (enc_utf8)
+	mch_memmove(lc->lc_uc, ScreenLinesUC + off,
+					      (size_t)width * sizeof(u8char_T));
+#endif
+    lc->lc_lnum = lnum;
+    lc->lc_fnum = wp->w_buffer->b_fnum;
+    lc->lc_changedtick = wp->w_buffer->b_changedtick;
+    lc->lc_tick = linecache_tick;
+    lc->lc_leftcol = wp->w_leftcol;
+    lc->lc_width = width;
+}
+
+/*
+ * Free w_linecache of window "wp".
+ */
+    void
+linecache_free(wp)
+    win_T	*wp;
+{
+    int		i;
+
+    if (wp->w_linecache == NULL)
+	return;
+    for (i = 0; i < LINECACHE_SIZE; ++i)
+    {
+	vim_free(wp->w_linecache[i].lc_chars);
+	vim_free(wp->w_linecache[i].lc_attrs);
+#ifdef FEAT_MBYTE
+	vim_free(wp->w_linecache[i].lc_uc);
+#endif
+    }
+    vim_free(wp->w_linecache);
+    wp->w_linecache = NULL;
+}
+
 /*
  * Clear the rest of the window and mark the unused lines with "c1".  use "c2"
  * as the filler character.
@@ -3084,7 +3298,7 @@ win_line(wp, lnum, startrow, endrow, nochange)
 	 * error, stop syntax highlighting. */
 	save_did_emsg = did_emsg;
 	did_emsg = FALSE;
-	syntax_start(wp, lnum);
+	syntax_start_cached(wp, lnum);
 	if (did_emsg)
 	    wp->w_s->b_syn_error = TRUE;
 	else
@@ -3362,7 +3576,16 @@ win_line(wp, lnum, startrow, endrow, nochange)
     if (v > 0)
     {
 #ifdef FEAT_MBYTE
-	char_u	*prev_ptr = ptr;
+	char_u	*prev_ptr;
+#endif
+	colnr_T	start_vcol = 0;
+
+	/* In a long line start at a remembered position before "v". */
+	ptr = line + getvcol_start(wp, lnum, line, (colnr_T)v - 1,
+								 &start_vcol);
+	vcol = start_vcol;
+#ifdef FEAT_MBYTE
+	prev_ptr = ptr;
 #endif
 	while (vcol < v && *ptr != NUL)
 	{
@@ -3459,7 +3682,7 @@ win_line(wp, lnum, startrow, endrow, nochange)
 # ifdef FEAT_SYN_HL
 	    /* Need to restart syntax highlighting for this line. */
 	    if (has_syntax)
-		syntax_start(wp, lnum);
+		syntax_start_cached(wp, lnum);
 # endif
 	}
 #endif
@@ -6033,7 +6256,68 @@ screen_line(row, coloff, endcol, clear_width
 		screen_char_2(off_to, row, col + coloff);
 	    else
 #endif
+	    {
 		screen_char(off_to, row, col + coloff);
+
+		/* When the terminal can repeat a character and the following
+		 * cells hold the same character with the same attributes,
+		 * output them with one repeat code if that is shorter. */
+		if (*T_RP != NUL && !p_wiv && !force
+#ifdef FEAT_GUI
+			&& !gui.in_use
+#endif
+#ifdef FEAT_MBYTE
+			&& enc_dbcs == 0
+			&& !(enc_utf8 && ScreenLinesUC[off_to] != 0)
+#endif
+			&& ScreenLines[off_to] >= ' '
+			&& ScreenLines[off_to] < 0x7f
+			&& screen_cur_row == row
+			&& screen_cur_col == col + coloff + 1)
+		{
+		    int		c = ScreenLines[off_to];
+		    int		n = 0;
+		    unsigned	off;
+
+		    /* Stop before the last screen column, writing there may
+		     * scroll or wrap. */
+		    for (off = off_from + 1; col + 1 + n < endcol
+			       && col + coloff + 1 + n < screen_Columns - 1;
+									++off)
+		    {
+			if (ScreenLines[off] != c
+				|| ScreenAttrs[off] != ScreenAttrs[off_to]
+#ifdef FEAT_MBYTE
+				|| (enc_utf8 && ScreenLinesUC[off] != 0)
+				|| (has_mbyte && (*mb_off2cells)(
+					     off_to + 1 + n, max_off_to) > 1)
+#endif
+				)
+			    break;
+			++n;
+		    }
+		    if (n > 3 && term_repeat_char(c, n) == OK)
+		    {
+			while (n > 0)
+			{
+			    ++off_to;
+			    ++off_from;
+			    ++col;
+			    --n;
+			    ScreenLines[off_to] = ScreenLines[off_from];
+#ifdef FEAT_MBYTE
+			    if (enc_utf8)
+				ScreenLinesUC[off_to] = 0;
+#endif
+			    ScreenAttrs[off_to] = ScreenAttrs[off_from];
+			    ++screen_cur_col;
+			}
+			/* Old highlighting may need redrawing of the next
+			 * character, as for the bold trick above. */
+			redraw_next = TRUE;
+		    }
+		}
+	    }
 	}
 	else if (  p_wiv
 #ifdef FEAT_GUI
@@ -7692,14 +7976,19 @@ next_search_hl(win, shl, lnum, mincol, cur)
 				&& shl == &cur->hl
 				&& cur->match.regprog == cur->hl.rm.regprog);
 
-	    nmatched = vim_regexec_multi(&shl->rm, win, shl->buf, lnum,
-		    matchcol,
+	    /* Skip a line that cannot contain a match. */
+	    if (matchcol == 0 && !vim_regline_may_match(&shl->rm, shl->buf,
+									lnum))
+		nmatched = 0;
+	    else
+		nmatched = vim_regexec_multi(&shl->rm, win, shl->buf, lnum,
+			matchcol,
 #ifdef FEAT_RELTIME
-		    &(shl->tm)
+			&(shl->tm)
 #else
-		    NULL
+			NULL
 #endif
-		    );
+			);
 	    /* Copy the regprog, in case it got freed and recompiled. */
 	    if (regprog_is_copy)
 		cur->match.regprog = cur->hl.rm.regprog;
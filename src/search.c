@@ -634,9 +634,13 @@ searchit(win, buf, pos, dir, pat, count, options, pat_use, stop_lnum, tm)
 #endif
 
 		/*
-		 * Look for a match somewhere in line "lnum".
+		 * Look for a match somewhere in line "lnum".  Quickly skip
+		 * lines that can't match.
 		 */
-		nmatched = vim_regexec_multi(&regmatch, win, buf,
+		if (!vim_regline_may_match(&regmatch, buf, lnum))
+		    nmatched = 0;
+		else
+		    nmatched = vim_regexec_multi(&regmatch, win, buf,
 						      lnum, (colnr_T)0,
 #ifdef FEAT_RELTIME
 						      tm
@@ -401,44 +401,51 @@ typedef struct memfile	    memfile_T;
 typedef long		    blocknr_T;
 
 /*
- * mf_hashtab_T is a chained hashtable with blocknr_T key and arbitrary
- * structures as items.  This is an intrusive data structure: we require
- * that items begin with mf_hashitem_T which contains the key and linked
- * list pointers.  List of items in each bucket is doubly-linked.
+ * mf_hashtab_T is an open addressing hashtable with blocknr_T key and
+ * arbitrary structures as items.  This is an intrusive data structure: we
+ * require that items begin with mf_hashitem_T which contains the key.
+ * Collisions are resolved by using the next free slot (linear probing).  The
+ * key is also stored in the slot, so that searching doesn't need to access
+ * the items.
  */
 
 typedef struct mf_hashitem_S mf_hashitem_T;
 
 struct mf_hashitem_S
 {
-    mf_hashitem_T   *mhi_next;
-    mf_hashitem_T   *mhi_prev;
     blocknr_T	    mhi_key;
 };
 
+typedef struct mf_hashslot_S
+{
+    blocknr_T	    mhs_key;	    /* key of "mhs_item" */
+    mf_hashitem_T   *mhs_item;	    /* NULL for an empty slot */
+} mf_hashslot_T;
+
 #define MHT_INIT_SIZE   64
 
 typedef struct mf_hashtab_S
 {
-    long_u	    mht_mask;	    /* mask used for hash value (nr of items
+    long_u	    mht_mask;	    /* mask used for hash value (nr of slots
 				     * in array is "mht_mask" + 1) */
     long_u	    mht_count;	    /* nr of items inserted into hashtable */
-    mf_hashitem_T   **mht_buckets;  /* points to mht_small_buckets or
-				     *dynamically allocated array */
-    mf_hashitem_T   *mht_small_buckets[MHT_INIT_SIZE];   /* initial buckets */
-    char	    mht_fixed;	    /* non-zero value forbids growth */
+    mf_hashslot_T   *mht_slots;	    /* points to mht_small_slots or
+				     * dynamically allocated array */
+    mf_hashslot_T   mht_small_slots[MHT_INIT_SIZE];   /* initial slots */
 } mf_hashtab_T;
 
 /*
  * for each (previously) used block in the memfile there is one block header.
  *
  * The block may be linked in the used list OR in the free list.
- * The used blocks are also kept in hash lists.
+ * The used blocks are also kept in a hashtable.
  *
- * The used list is a doubly linked list, most recently used block first.
+ * The used list is a doubly linked list, most recently added block first.
+ *	Getting a block only sets BH_REFERENCED, the list is changed when a
+ *	block must be released (CLOCK replacement, see mf_release()).
  *	The blocks in the used list have a block of memory allocated.
  *	mf_used_count is the number of pages in the used list.
- * The hash lists are used to quickly find a block in the used list.
+ * The hashtable is used to quickly find a block in the used list.
  * The free list is a single linked list, not sorted.
  *	The blocks in the free list have no block of memory allocated and
  *	the contents of the block in the file (if any) is irrelevant.
@@ -453,17 +460,20 @@ struct block_hdr
     bhdr_T	*bh_prev;	    /* previous block_hdr in used list */
     char_u	*bh_data;	    /* pointer to memory (for used block) */
     int		bh_page_count;	    /* number of pages in this block */
+    unsigned	bh_csize;	    /* size of compressed bh_data, zero when
+				       not compressed */
 
 #define BH_DIRTY    1
 #define BH_LOCKED   2
-    char	bh_flags;	    /* BH_DIRTY or BH_LOCKED */
+#define BH_REFERENCED 4		    /* used since last checked for release */
+    char	bh_flags;	    /* BH_DIRTY, BH_LOCKED, BH_REFERENCED */
 };
 
 /*
  * when a block with a negative number is flushed to the file, it gets
  * a positive number. Because the reference to the block is still the negative
  * number, we remember the translation to the new positive number in the
- * double linked trans lists. The structure is the same as the hash lists.
+ * trans hashtable. The structure is the same as the block hashtable.
  */
 typedef struct nr_trans NR_TRANS;
 
@@ -565,18 +575,30 @@ struct memfile
     char_u	*mf_ffname;		/* idem, full path */
     int		mf_fd;			/* file descriptor */
     bhdr_T	*mf_free_first;		/* first block_hdr in free list */
-    bhdr_T	*mf_used_first;		/* mru block_hdr in used list */
-    bhdr_T	*mf_used_last;		/* lru block_hdr in used list */
+    bhdr_T	*mf_used_first;		/* newest block_hdr in used list */
+    bhdr_T	*mf_used_last;		/* oldest block_hdr in used list */
     unsigned	mf_used_count;		/* number of pages in used list */
     unsigned	mf_used_count_max;	/* maximum number of pages in memory */
-    mf_hashtab_T mf_hash;		/* hash lists */
-    mf_hashtab_T mf_trans;		/* trans lists */
+    mf_hashtab_T mf_hash;		/* hashtable of used blocks */
+    mf_hashtab_T mf_trans;		/* hashtable of translations */
     blocknr_T	mf_blocknr_max;		/* highest positive block number + 1*/
     blocknr_T	mf_blocknr_min;		/* lowest negative block number - 1 */
     blocknr_T	mf_neg_count;		/* number of negative blocks numbers */
     blocknr_T	mf_infile_count;	/* number of pages in the file */
     unsigned	mf_page_size;		/* number of bytes in a page */
     int		mf_dirty;		/* TRUE if there are dirty blocks */
+
+    /* statistics for ":swapstats" */
+    long	mf_stat_writes;		/* number of blocks written */
+    long	mf_stat_syncs;		/* number of calls to mf_sync() */
+    long	mf_stat_flushes;	/* number of times flushed to disk */
+    long	mf_stat_postponed;	/* flushes postponed for typeahead */
+    long	mf_comp_count;		/* number of compressed blocks */
+    long_u	mf_comp_size;		/* bytes used by compressed blocks */
+#ifdef FEAT_PROFILE
+    proftime_T	mf_stat_total;		/* total time spent in mf_sync() */
+    proftime_T	mf_stat_slowest;	/* time of slowest mf_sync() */
+#endif
 #ifdef FEAT_CRYPT
     buf_T	*mf_buffer;		/* buffer this memfile is for */
     char_u	mf_seed[MF_SEED_LEN];	/* seed for encryption */
@@ -605,6 +627,24 @@ typedef struct info_pointer
     int		ip_index;	/* index for block with current lnum */
 } infoptr_T;	/* block/index pair */
 
+/*
+ * Entry in the cache of recently used data blocks, see ml_find_line().
+ * Remembers the line range of a data block and the stack of pointer blocks
+ * leading to it, so that a random lookup doesn't need to walk the tree.
+ */
+#define ML_CACHE_SIZE	8	/* nr of data blocks remembered */
+#define ML_CACHE_DEPTH	4	/* max nr of pointer blocks in stack */
+
+typedef struct ml_cache
+{
+    blocknr_T	mc_bnum;	/* block number of the data block */
+    int		mc_page_count;	/* number of pages in the data block */
+    linenr_T	mc_low;		/* first line in the data block */
+    linenr_T	mc_high;	/* last line in the data block */
+    int		mc_stack_top;	/* number of entries in mc_stack */
+    infoptr_T	mc_stack[ML_CACHE_DEPTH]; /* copy of ml_stack */
+} mlcache_T;
+
 #ifdef FEAT_BYTEOFF
 typedef struct ml_chunksize
 {
@@ -632,6 +672,7 @@ typedef struct memline
 #define ML_LINE_DIRTY	2	/* cached line was changed and allocated */
 #define ML_LOCKED_DIRTY	4	/* ml_locked was changed */
 #define ML_LOCKED_POS	8	/* ml_locked needs positive block number */
+#define ML_APPEND_BULK	16	/* many lines are appended one after another */
     int		ml_flags;
 
     infoptr_T	*ml_stack;	/* stack of pointer blocks (array of IPTRs) */
@@ -645,10 +686,19 @@ typedef struct memline
     linenr_T	ml_locked_low;	/* first line in ml_locked */
     linenr_T	ml_locked_high;	/* last line in ml_locked */
     int		ml_locked_lineadd;  /* number of lines inserted in ml_locked */
+
+    mlcache_T	*ml_cache;	/* recently used data blocks, most recent
+				   first; NULL when not allocated yet */
+    int		ml_cache_len;	/* number of valid entries in ml_cache */
+    long	ml_cache_hits;	/* lookups found in ml_cache */
+    long	ml_cache_misses; /* lookups that walked the tree */
 #ifdef FEAT_BYTEOFF
     chunksize_T *ml_chunksize;
     int		ml_numchunks;
     int		ml_usedchunks;
+    chunksize_T *ml_chunktree;	/* Fenwick tree with sums of ml_chunksize */
+    int		ml_chunktree_len;   /* nr of entries allocated in ml_chunktree */
+    int		ml_chunktree_valid; /* FALSE when ml_chunktree must be rebuilt */
 #endif
 } memline_T;
 
@@ -891,6 +941,32 @@ struct syn_state
     linenr_T	sst_change_lnum;/* when non-zero, change in this line
 				 * may have made the state invalid */
 };
+
+/*
+ * Syntax attributes for a sequence of columns in a line, see
+ * syntax_start_cached().
+ */
+typedef struct syn_attr_run
+{
+    colnr_T	sar_endcol;	/* last column of the run */
+    int		sar_attr;	/* attributes, as returned by get_syntax_attr() */
+    int		sar_can_spell;	/* spell checking allowed */
+    int		sar_id;		/* current_id */
+    int		sar_trans_id;	/* current_trans_id */
+    int		sar_flags;	/* current_flags */
+    int		sar_seqnr;	/* current_seqnr */
+    int		sar_sub_char;	/* current_sub_char */
+} synattr_run_T;
+
+typedef struct syn_attr_line
+{
+    linenr_T	sal_lnum;	/* line number, zero when not used */
+    int		sal_tick;	/* b_changedtick when stored */
+    int		sal_hl_tick;	/* highlight tick when stored */
+    int		sal_opt_tick;	/* linecache_tick when stored */
+    colnr_T	sal_col;	/* number of columns stored */
+    garray_T	sal_runs;	/* growarray of synattr_run_T */
+} synattr_line_T;
 #endif /* FEAT_SYN_HL */
 
 /*
@@ -1261,6 +1337,7 @@ typedef struct qf_info_S qf_info_T;
 typedef struct {
     proftime_T	total;		/* total time used */
     proftime_T	slowest;	/* time of slowest call */
+    linenr_T	slowest_lnum;	/* line of slowest call */
     long	count;		/* nr of times used */
     long	match;		/* nr of times matched */
 } syn_time_T;
@@ -1333,6 +1410,14 @@ typedef struct {
      * b_sst_freecount	number of free entries in b_sst_array[]
      * b_sst_check_lnum	entries after this lnum need to be checked for
      *			validity (MAXLNUM means no check needed)
+     * b_sst_idle_lnum	states were computed up to this line while waiting
+     *			for a typed character, see syn_idle_update()
+     * b_sst_idle_tick	b_changedtick when b_sst_idle_lnum was set
+     * b_sst_cache_tried  TRUE when tried reading the states from the
+     *			syntax cache file, see 'syntaxcache'
+     * b_sst_cache_lnum	last line of the states in the cache file
+     * b_sst_cache_tick	b_changedtick when the cache file was read or
+     *			written
      */
     synstate_T	*b_sst_array;
     int		b_sst_len;
@@ -1341,6 +1426,19 @@ typedef struct {
     int		b_sst_freecount;
     linenr_T	b_sst_check_lnum;
     short_u	b_sst_lasttick;	/* last display tick */
+    linenr_T	b_sst_idle_lnum;
+    int		b_sst_idle_tick;
+# ifdef FEAT_PERSISTENT_UNDO
+    int		b_sst_cache_tried;
+    linenr_T	b_sst_cache_lnum;
+    int		b_sst_cache_tick;
+# endif
+
+    /* Attributes of recently displayed lines, to redraw them without parsing
+     * when nothing changed, see syntax_start_cached().  b_sal_usable is zero
+     * when not checked yet whether the patterns allow this. */
+    synattr_line_T *b_sal_array;
+    int		b_sal_usable;
 #endif /* FEAT_SYN_HL */
 
 #ifdef FEAT_SPELL
@@ -1507,6 +1605,12 @@ struct file_buffer
     long	b_u_seq_cur;	/* hu_seq of header below which we are now */
     time_t	b_u_time_cur;	/* uh_time of header below which we are now */
     long	b_u_save_nr_cur; /* file write nr after which we are now */
+#ifdef FEAT_PERSISTENT_UNDO
+    char_u	b_u_hash[UNDO_HASH_SIZE]; /* hash of the text, computed when
+					     reading or writing the file */
+    int		b_u_hash_valid;	/* b_u_hash can be used */
+    int		b_u_hash_tick;	/* b_changedtick when b_u_hash was set */
+#endif
 
     /*
      * variables for "U" command in undo.c
@@ -1930,6 +2034,40 @@ typedef struct w_line
 #endif
 } wline_T;
 
+/*
+ * Screen cells of a buffer line as last drawn by win_line(), to redraw the
+ * line without formatting it again, see w_linecache.  Only used for lines
+ * that take one screen row.  The entry is valid while the buffer, its
+ * b_changedtick, the window width, w_leftcol and linecache_tick are the same.
+ */
+typedef struct line_cache
+{
+    linenr_T	lc_lnum;	/* buffer line number, zero when not used */
+    int		lc_fnum;	/* buffer number */
+    int		lc_changedtick;	/* b_changedtick when stored */
+    int		lc_tick;	/* linecache_tick when stored */
+    colnr_T	lc_leftcol;	/* w_leftcol when stored */
+    int		lc_width;	/* number of cells in lc_chars[] etc. */
+    schar_T	*lc_chars;	/* text, as in ScreenLines[] */
+    sattr_T	*lc_attrs;	/* attributes, as in ScreenAttrs[] */
+#ifdef FEAT_MBYTE
+    u8char_T	*lc_uc;		/* as in ScreenLinesUC[], when enc_utf8 */
+#endif
+} linecache_T;
+
+#define LINECACHE_SIZE	128	/* entries in w_linecache[] */
+
+/*
+ * Virtual column of a character in a long line, remembered by getvcol().
+ */
+typedef struct vcol_mark
+{
+    colnr_T	vm_col;		/* byte index of the character */
+    colnr_T	vm_vcol;	/* virtual column where it starts */
+} vcolmark_T;
+
+#define VCOL_MARK_BYTES	4096	/* bytes between vcolmark_T entries */
+
 /*
  * Windows are kept in a tree of frames.  Each frame has a column (FR_COL)
  * or row (FR_ROW) layout or is a leaf, which has a window.
@@ -2172,6 +2310,27 @@ struct window_S
     int		w_lines_valid;	    /* number of valid entries */
     wline_T	*w_lines;
 
+    /*
+     * Screen cells of recently drawn lines, LINECACHE_SIZE entries indexed
+     * by line number.  NULL until used.
+     */
+    linecache_T	*w_linecache;
+
+    /*
+     * Virtual columns at every VCOL_MARK_BYTES bytes of line w_vcol_lnum, to
+     * avoid counting from the start of a long line in getvcol(),
+     * coladvance() and win_line().  Valid while the buffer, its
+     * b_changedtick, linecache_tick and the text width are the same.
+     */
+    linenr_T	w_vcol_lnum;	    /* line number, zero when not used */
+    int		w_vcol_fnum;	    /* buffer number */
+    int		w_vcol_changedtick; /* b_changedtick when valid */
+    int		w_vcol_tick;	    /* linecache_tick when valid */
+    int		w_vcol_width;	    /* width of first screen line */
+    int		w_vcol_off2;	    /* win_col_off2() */
+    int		w_vcol_complete;    /* TRUE when marks cover whole line */
+    garray_T	w_vcol_marks;	    /* growarray of vcolmark_T */
+
 #ifdef FEAT_FOLDING
     garray_T	w_folds;	    /* array of nested folds */
     char	w_fold_manual;	    /* when TRUE: some folds are opened/closed
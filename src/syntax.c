@@ -375,13 +375,39 @@ static int	current_line_id = 0;	/* unique number for current line */
 
 #define CUR_STATE(idx)	((stateitem_T *)(current_state.ga_data))[idx]
 
+#define SYN_IDLE_LINES	50	/* nr of lines parsed at a time when idle */
+#define SYN_ATTR_LINES	256	/* nr of lines with cached attributes */
+#define SYN_ATTR_RUNS	2000	/* max nr of cached runs for one line */
+
+/* values for b_sal_usable */
+#define SAL_UNKNOWN	0
+#define SAL_USABLE	1
+#define SAL_NOT_USABLE	2
+
+static synattr_line_T *syn_attr_replay = NULL;	/* line redrawn from cache */
+static synattr_line_T *syn_attr_store = NULL;	/* line stored in cache */
+static int syn_attr_hl_tick = 0;	/* incremented when highlight
+					   attributes may have changed */
+
 static void syn_sync __ARGS((win_T *wp, linenr_T lnum, synstate_T *last_valid));
 static int syn_match_linecont __ARGS((linenr_T lnum));
 static void syn_start_line __ARGS((void));
 static void syn_update_ends __ARGS((int startofline));
 static void syn_stack_alloc __ARGS((void));
 static int syn_stack_cleanup __ARGS((void));
+static synattr_line_T *syn_attr_find_line __ARGS((win_T *wp, linenr_T lnum));
+static void syn_attr_store_col __ARGS((int attr, int can_spell));
+static int syn_attr_replay_col __ARGS((colnr_T col, int *can_spell));
+static void syn_attr_free_lines __ARGS((synblock_T *block));
 static void syn_stack_free_entry __ARGS((synblock_T *block, synstate_T *p));
+#ifdef FEAT_PERSISTENT_UNDO
+static int syn_cache_useful __ARGS((buf_T *buf));
+static void syn_cache_hash_nr __ARGS((context_sha256_T *ctx, long n));
+static void syn_cache_hash_ids __ARGS((context_sha256_T *ctx, synblock_T *block, short *list));
+static void syn_cache_syntax_hash __ARGS((buf_T *buf, char_u *hash));
+static int syn_cache_state_valid __ARGS((synstate_T *p));
+static void syn_cache_read __ARGS((void));
+#endif
 static synstate_T *syn_stack_find_entry __ARGS((linenr_T lnum));
 static synstate_T *store_current_state __ARGS((void));
 static void load_current_state __ARGS((synstate_T *from));
@@ -408,8 +434,12 @@ static int _RTLENTRYF syn_compare_syntime __ARGS((const void *v1, const void *v2
 #else
 static int syn_compare_syntime __ARGS((const void *v1, const void *v2));
 #endif
+static int syntime_collect __ARGS((garray_T *gap, proftime_T *total, long *count));
 static void syntime_report __ARGS((void));
+static void syntime_write __ARGS((char_u *fname));
 static int syn_time_on = FALSE;
+static int syn_time_sort = 0;	/* how to sort ":syntime report", index in
+				   syntime_sort_names[] */
 # define IF_SYN_TIME(p) (p)
 #else
 # define IF_SYN_TIME(p) NULL
@@ -499,6 +529,8 @@ syntax_start(wp, lnum)
     int		dist;
     static int	changedtick = 0;	/* remember the last change ID */
 
+    syn_attr_replay = NULL;
+    syn_attr_store = NULL;
 #ifdef FEAT_CONCEAL
     current_sub_char = NUL;
 #endif
@@ -524,6 +556,10 @@ syntax_start(wp, lnum)
     if (syn_block->b_sst_array == NULL)
 	return;		/* out of memory */
     syn_block->b_sst_lasttick = display_tick;
+#ifdef FEAT_PERSISTENT_UNDO
+    if (syn_block->b_sst_first == NULL && !syn_block->b_sst_cache_tried)
+	syn_cache_read();
+#endif
 
     /*
      * If the state of the end of the previous line is useful, store it.
@@ -660,6 +696,144 @@ syntax_start(wp, lnum)
     syn_start_line();
 }
 
+/*
+ * Return TRUE when the syntax items for window "wp" may match differently
+ * when only the cursor moved: patterns with "\%#", "\%V" or "\%'m" depend on
+ * the cursor position, the Visual area or a mark.  Also for "\%23v", the
+ * virtual column depends on window options such as 'list'.
+ */
+    int
+syntax_uses_cursor(wp)
+    win_T	*wp;
+{
+    synblock_T	*block = wp->w_s;
+    char_u	*p;
+    char_u	*q;
+    int		i;
+
+    if (block->b_sal_usable == SAL_UNKNOWN)
+    {
+	block->b_sal_usable = SAL_USABLE;
+	for (i = 0; i < block->b_syn_patterns.ga_len; ++i)
+	{
+	    p = SYN_ITEMS(block)[i].sp_pattern;
+	    if (p != NULL)
+		for (p = vim_strchr(p, '%'); p != NULL;
+						    p = vim_strchr(p + 1, '%'))
+		{
+		    if (p[1] == '#' || p[1] == 'V' || p[1] == '\'')
+			block->b_sal_usable = SAL_NOT_USABLE;
+		    else
+		    {
+			q = p + 1;
+			if (*q == '<' || *q == '>')
+			    ++q;
+			q = skipdigits(q);
+			if (q > p + 1 && *q == 'v')
+			    block->b_sal_usable = SAL_NOT_USABLE;
+		    }
+		}
+	}
+    }
+    return block->b_sal_usable != SAL_USABLE;
+}
+
+/*
+ * Like syntax_start(), but when the attributes of line "lnum" were stored
+ * while it was displayed before, and the text and the syntax items did not
+ * change since then, get_syntax_attr() returns the stored attributes without
+ * parsing the line.  Otherwise the attributes are stored while parsing.
+ * Only to be used for displaying a line: the syntax state stack isn't valid
+ * for "lnum" when the stored attributes are used.
+ */
+    void
+syntax_start_cached(wp, lnum)
+    win_T	*wp;
+    linenr_T	lnum;
+{
+    synattr_line_T	*sal = syn_attr_find_line(wp, lnum);
+
+    if (sal != NULL && sal->sal_lnum == lnum
+	    && sal->sal_tick == wp->w_buffer->b_changedtick
+	    && sal->sal_hl_tick == syn_attr_hl_tick
+	    && sal->sal_opt_tick == linecache_tick)
+    {
+	if (syn_block != wp->w_s)
+	    invalidate_current_state();
+	syn_buf = wp->w_buffer;
+	syn_block = wp->w_s;
+	syn_win = wp;
+	syn_attr_store = NULL;
+	syn_attr_replay = sal;
+	return;
+    }
+
+    syntax_start(wp, lnum);
+    if (sal != NULL && syn_block->b_sst_array != NULL && !got_int)
+    {
+	sal->sal_lnum = lnum;
+	sal->sal_tick = wp->w_buffer->b_changedtick;
+	sal->sal_hl_tick = syn_attr_hl_tick;
+	sal->sal_opt_tick = linecache_tick;
+	sal->sal_col = 0;
+	sal->sal_runs.ga_len = 0;
+	syn_attr_store = sal;
+    }
+}
+
+/*
+ * Find the entry in the cache of line attributes to use for line "lnum".
+ * Returns NULL when the cache can't be used.
+ */
+    static synattr_line_T *
+syn_attr_find_line(wp, lnum)
+    win_T	*wp;
+    linenr_T	lnum;
+{
+    synblock_T	*block = wp->w_s;
+    int		i;
+
+    if (syntax_uses_cursor(wp))
+	return NULL;
+
+    if (block->b_sal_array == NULL)
+    {
+	block->b_sal_array = (synattr_line_T *)alloc_clear(
+			      (unsigned)(SYN_ATTR_LINES * sizeof(synattr_line_T)));
+	if (block->b_sal_array == NULL)
+	    return NULL;
+	for (i = 0; i < SYN_ATTR_LINES; ++i)
+	    ga_init2(&block->b_sal_array[i].sal_runs,
+					     (int)sizeof(synattr_run_T), 10);
+    }
+    return &block->b_sal_array[lnum % SYN_ATTR_LINES];
+}
+
+/*
+ * Free the cached line attributes for "block".
+ */
+    static void
+syn_attr_free_lines(block)
+    synblock_T	*block;
+{
+    int		i;
+
+    if (block->b_sal_array != NULL)
+    {
+	if (syn_attr_replay != NULL || syn_attr_store != NULL)
+	{
+	    syn_attr_replay = NULL;
+	    syn_attr_store = NULL;
+	    invalidate_current_state();
+	}
+	for (i = 0; i < SYN_ATTR_LINES; ++i)
+	    ga_clear(&block->b_sal_array[i].sal_runs);
+	vim_free(block->b_sal_array);
+	block->b_sal_array = NULL;
+    }
+    block->b_sal_usable = SAL_UNKNOWN;
+}
+
 /*
  * We cannot simply discard growarrays full of state_items or buf_states; we
  * have to manually release their extmatch pointers first.
@@ -1148,7 +1322,13 @@ syn_stack_free_block(block)
 	vim_free(block->b_sst_array);
 	block->b_sst_array = NULL;
 	block->b_sst_len = 0;
+	block->b_sst_idle_lnum = 0;
+#ifdef FEAT_PERSISTENT_UNDO
+	block->b_sst_cache_tried = FALSE;
+	block->b_sst_cache_lnum = 0;
+#endif
     }
+    syn_attr_free_lines(block);
 }
 /*
  * Free b_sst_array[] for buffer "buf".
@@ -1161,7 +1341,7 @@ syn_stack_free_all(block)
     win_T	*wp;
 
     syn_stack_free_block(block);
-
+    ++linecache_tick;		/* drawn lines may be highlighted differently */
 
 #ifdef FEAT_FOLDING
     /* When using "syntax" fold method, must update all folds. */
@@ -1323,6 +1503,521 @@ syn_stack_apply_changes_block(block, buf)
     }
 }
 
+/*
+ * Called when waiting for the user to type a character.  Computes the syntax
+ * state for lines below the current window, SYN_IDLE_LINES at a time, until a
+ * character is available.  The stored states are used when jumping further
+ * down in the buffer, so that parsing doesn't have to start far back.  Only
+ * done when syncing goes back more than a few lines, e.g. with "fromstart".
+ */
+    void
+syn_idle_update()
+{
+    synblock_T	*block = curwin->w_s;
+    linenr_T	lnum;
+    int		state = get_real_state();
+
+    if (!syntax_present(curwin)
+	    || block->b_syn_sync_minlines <= SYN_IDLE_LINES
+	    || (state != NORMAL_BUSY && (state & INSERT) == 0)
+	    || typebuf.tb_len > 0
+	    || curbuf->b_mod_set
+#ifdef FEAT_INS_EXPAND
+	    || ins_compl_active()
+#endif
+	    )
+	return;
+
+    /* After a change start again below the window, states that didn't
+     * change are found quickly. */
+    if (block->b_sst_idle_tick != curbuf->b_changedtick)
+    {
+	block->b_sst_idle_lnum = 0;
+	block->b_sst_idle_tick = curbuf->b_changedtick;
+    }
+
+    while (block->b_sst_idle_lnum < curbuf->b_ml.ml_line_count
+							   && !ui_char_avail())
+    {
+	lnum = block->b_sst_idle_lnum;
+	if (lnum < curwin->w_botline)
+	    lnum = curwin->w_botline;
+	lnum += SYN_IDLE_LINES;
+	if (lnum > curbuf->b_ml.ml_line_count)
+	    lnum = curbuf->b_ml.ml_line_count;
+	syntax_start(curwin, lnum);
+	if (block->b_sst_array == NULL)
+	    break;	/* out of memory */
+	block->b_sst_idle_lnum = lnum;
+#ifdef FEAT_PERSISTENT_UNDO
+	/* Parsed the whole buffer, keep the states for next time. */
+	if (lnum == curbuf->b_ml.ml_line_count && block == &curbuf->b_s)
+	    syn_cache_write(curbuf);
+#endif
+    }
+}
+
+#if defined(FEAT_PERSISTENT_UNDO) || defined(PROTO)
+/*
+ * When 'syntaxcache' is set the syntax states of a buffer are written to a
+ * file next to the undo file.  When the same text is edited again with the
+ * same syntax items the states are read back, so that jumping far down in the
+ * file doesn't require parsing all the lines above it.
+ * The file contains:
+ *	SYC_MAGIC, SYC_VERSION (2 bytes)
+ *	hash of the text, number of lines (4 bytes)
+ *	hash of the syntax items
+ *	number of states (4 bytes), for each state:
+ *	    line number, next flags, stack size (4 bytes each)
+ *	    for each stack item: index + 1, flags, seqnr, cchar (4 bytes each)
+ */
+#define SYC_MAGIC	"Vim\237SynCache"
+#define SYC_MAGIC_LEN	12
+#define SYC_VERSION	1
+#define SYC_EXT		".sy~"
+#define SYC_MAX_STACK	1000	/* sanity check for the stack size */
+
+/*
+ * Return TRUE if the syntax states of "buf" are worth keeping in a file:
+ * syncing may go back many lines and the buffer is not modified.
+ */
+    static int
+syn_cache_useful(buf)
+    buf_T	*buf;
+{
+    return p_syc
+	    && buf->b_ffname != NULL
+	    && buf->b_ml.ml_mfp != NULL
+	    && !bufIsChanged(buf)
+	    && buf->b_s.b_syn_patterns.ga_len > 0
+	    && buf->b_s.b_syn_sync_minlines > SYN_IDLE_LINES;
+}
+
+/*
+ * Add a number to the hash.
+ */
+    static void
+syn_cache_hash_nr(ctx, n)
+    context_sha256_T	*ctx;
+    long		n;
+{
+    sha256_update(ctx, (char_u *)&n, (UINT32_T)sizeof(n));
+}
+
+/*
+ * Add the group IDs in "list" to the hash.  The names are used, the IDs may
+ * be different in another Vim.
+ */
+    static void
+syn_cache_hash_ids(ctx, block, list)
+    context_sha256_T	*ctx;
+    synblock_T		*block;
+    short		*list;
+{
+    char_u	buf[20];
+    char_u	*name;
+    short	*p;
+
+    if (list != NULL)
+	for (p = list; *p != 0; ++p)
+	{
+	    name = NULL;
+	    if (*p >= SYNID_CLUSTER
+		    && *p - SYNID_CLUSTER < block->b_syn_clusters.ga_len)
+		name = SYN_CLSTR(block)[*p - SYNID_CLUSTER].scl_name;
+	    else if (*p > 0 && *p <= highlight_ga.ga_len)
+		name = HL_TABLE()[*p - 1].sg_name;
+	    if (name == NULL)
+	    {
+		sprintf((char *)buf, "#%d", *p);
+		name = buf;
+	    }
+	    sha256_update(ctx, name, (UINT32_T)(STRLEN(name) + 1));
+	}
+    sha256_update(ctx, (char_u *)"", 1);
+}
+
+/*
+ * Compute a hash for everything that the syntax states of "buf" depend on,
+ * other than the text: the syntax items and a few options.
+ */
+    static void
+syn_cache_syntax_hash(buf, hash)
+    buf_T	*buf;
+    char_u	*hash;
+{
+    synblock_T		*block = &buf->b_s;
+    context_sha256_T	ctx;
+    synpat_T		*spp;
+    keyentry_T		*kp;
+    hashtab_T		*ht;
+    hashitem_T		*hi;
+    short		id[2];
+    long		todo;
+    int			i;
+
+    sha256_start(&ctx);
+    sha256_update(&ctx, p_enc, (UINT32_T)(STRLEN(p_enc) + 1));
+    sha256_update(&ctx, buf->b_p_isk, (UINT32_T)(STRLEN(buf->b_p_isk) + 1));
+    syn_cache_hash_nr(&ctx, buf->b_p_smc);
+    syn_cache_hash_nr(&ctx, block->b_syn_ic);
+    syn_cache_hash_nr(&ctx, block->b_syn_containedin);
+    syn_cache_hash_nr(&ctx, block->b_syn_sync_flags);
+    syn_cache_hash_nr(&ctx, block->b_syn_sync_minlines);
+    syn_cache_hash_nr(&ctx, block->b_syn_sync_maxlines);
+    syn_cache_hash_nr(&ctx, block->b_syn_sync_linebreaks);
+    id[0] = block->b_syn_sync_id;
+    id[1] = 0;
+    syn_cache_hash_ids(&ctx, block, id);
+    if (block->b_syn_linecont_pat != NULL)
+    {
+	sha256_update(&ctx, block->b_syn_linecont_pat,
+		       (UINT32_T)(STRLEN(block->b_syn_linecont_pat) + 1));
+	syn_cache_hash_nr(&ctx, block->b_syn_linecont_ic);
+    }
+
+    syn_cache_hash_nr(&ctx, block->b_syn_patterns.ga_len);
+    for (i = 0; i < block->b_syn_patterns.ga_len; ++i)
+    {
+	spp = &(SYN_ITEMS(block)[i]);
+	syn_cache_hash_nr(&ctx, spp->sp_type);
+	syn_cache_hash_nr(&ctx, spp->sp_syncing);
+	syn_cache_hash_nr(&ctx, spp->sp_flags);
+	syn_cache_hash_nr(&ctx, spp->sp_ic);
+	syn_cache_hash_nr(&ctx, spp->sp_off_flags);
+	syn_cache_hash_nr(&ctx, spp->sp_sync_idx);
+	syn_cache_hash_nr(&ctx, spp->sp_syn.inc_tag);
+	sha256_update(&ctx, (char_u *)spp->sp_offsets,
+					  (UINT32_T)sizeof(spp->sp_offsets));
+	if (spp->sp_pattern != NULL)
+	    sha256_update(&ctx, spp->sp_pattern,
+				    (UINT32_T)(STRLEN(spp->sp_pattern) + 1));
+	id[0] = spp->sp_syn.id;
+	syn_cache_hash_ids(&ctx, block, id);
+	syn_cache_hash_ids(&ctx, block, spp->sp_syn.cont_in_list);
+	syn_cache_hash_ids(&ctx, block, spp->sp_cont_list);
+	syn_cache_hash_ids(&ctx, block, spp->sp_next_list);
+    }
+
+    for (i = 0; i < block->b_syn_clusters.ga_len; ++i)
+	syn_cache_hash_ids(&ctx, block, SYN_CLSTR(block)[i].scl_list);
+
+    for (ht = &block->b_keywtab; ht != NULL;
+		ht = ht == &block->b_keywtab ? &block->b_keywtab_ic : NULL)
+    {
+	todo = (long)ht->ht_used;
+	syn_cache_hash_nr(&ctx, todo);
+	for (hi = ht->ht_array; todo > 0; ++hi)
+	    if (!HASHITEM_EMPTY(hi))
+	    {
+		--todo;
+		for (kp = HI2KE(hi); kp != NULL; kp = kp->ke_next)
+		{
+		    sha256_update(&ctx, kp->keyword,
+					 (UINT32_T)(STRLEN(kp->keyword) + 1));
+		    syn_cache_hash_nr(&ctx, kp->flags);
+		    syn_cache_hash_nr(&ctx, kp->k_syn.inc_tag);
+		    id[0] = kp->k_syn.id;
+		    syn_cache_hash_ids(&ctx, block, id);
+		    syn_cache_hash_ids(&ctx, block, kp->k_syn.cont_in_list);
+		    syn_cache_hash_ids(&ctx, block, kp->next_list);
+		}
+	    }
+    }
+
+    sha256_finish(&ctx, hash);
+}
+
+/*
+ * Return TRUE if state "p" can be written to the cache file.  States that may
+ * have become invalid by a change, and states that refer to something that
+ * can't be written, are skipped.
+ */
+    static int
+syn_cache_state_valid(p)
+    synstate_T	*p;
+{
+    bufstate_T	*bp;
+    int		i;
+
+    if (p->sst_change_lnum != 0 || p->sst_next_list != NULL)
+	return FALSE;
+    if (p->sst_stacksize > SST_FIX_STATES)
+	bp = SYN_STATE_P(&(p->sst_union.sst_ga));
+    else
+	bp = p->sst_union.sst_stack;
+    for (i = 0; i < p->sst_stacksize; ++i)
+	if (bp[i].bs_extmatch != NULL)
+	    return FALSE;
+    return TRUE;
+}
+
+/*
+ * Write the syntax states of buffer "buf" to the cache file.  Nothing is done
+ * when 'syntaxcache' is off or when the file already has these states.
+ */
+    void
+syn_cache_write(buf)
+    buf_T	*buf;
+{
+    synblock_T	*block = &buf->b_s;
+    synstate_T	*p;
+    bufstate_T	*bp;
+    linenr_T	last_lnum = 0;
+    long	count = 0;
+    char_u	*file_name;
+    FILE	*fp;
+    int		fd;
+    char_u	magic_buf[SYC_MAGIC_LEN];
+    char_u	hash[UNDO_HASH_SIZE];
+    int		ok;
+    int		i;
+
+    if (block->b_sst_array == NULL || !syn_cache_useful(buf))
+	return;
+    for (p = block->b_sst_first; p != NULL; p = p->sst_next)
+	if (syn_cache_state_valid(p))
+	{
+	    ++count;
+	    last_lnum = p->sst_lnum;
+	}
+    if (count == 0 || (block->b_sst_cache_tick == buf->b_changedtick
+				    && last_lnum <= block->b_sst_cache_lnum))
+	return;
+    block->b_sst_cache_tick = buf->b_changedtick;
+    block->b_sst_cache_lnum = last_lnum;
+
+    file_name = u_get_cache_file_name(buf->b_ffname, FALSE, SYC_EXT);
+    if (file_name == NULL)
+	return;
+
+    /* If the file already exists, verify that it actually is a syntax cache
+     * file, and delete it.  Like u_write_undo() does. */
+    if (mch_getperm(file_name) >= 0)
+    {
+	fd = mch_open((char *)file_name, O_RDONLY|O_EXTRA, 0);
+	if (fd < 0 || read_eintr(fd, magic_buf, SYC_MAGIC_LEN) < SYC_MAGIC_LEN
+		|| memcmp(magic_buf, SYC_MAGIC, SYC_MAGIC_LEN) != 0)
+	{
+	    if (fd >= 0)
+		close(fd);
+	    if (p_verbose > 0)
+	    {
+		verbose_enter();
+		smsg((char_u *)
+		  _("Will not overwrite, this is not a syntax cache: %s"),
+								   file_name);
+		verbose_leave();
+	    }
+	    vim_free(file_name);
+	    return;
+	}
+	close(fd);
+	mch_remove(file_name);
+    }
+
+    fd = u_create_cache_file(buf, file_name);
+    fp = fd < 0 ? NULL : fdopen(fd, "w");
+    if (fd >= 0 && fp == NULL)
+    {
+	close(fd);
+	mch_remove(file_name);
+    }
+    if (fp != NULL)
+    {
+	if (p_verbose > 0)
+	{
+	    verbose_enter();
+	    smsg((char_u *)_("Writing syntax cache: %s"), file_name);
+	    verbose_leave();
+	}
+	ok = fwrite(SYC_MAGIC, (size_t)SYC_MAGIC_LEN, (size_t)1, fp) == 1
+		&& put_bytes(fp, (long_u)SYC_VERSION, 2) == OK;
+	u_compute_buf_hash(buf, hash);
+	ok = ok && fwrite(hash, (size_t)UNDO_HASH_SIZE, (size_t)1, fp) == 1
+		&& put_bytes(fp, (long_u)buf->b_ml.ml_line_count, 4) == OK;
+	syn_cache_syntax_hash(buf, hash);
+	ok = ok && fwrite(hash, (size_t)UNDO_HASH_SIZE, (size_t)1, fp) == 1
+		&& put_bytes(fp, (long_u)count, 4) == OK;
+
+	for (p = block->b_sst_first; ok && p != NULL; p = p->sst_next)
+	{
+	    if (!syn_cache_state_valid(p))
+		continue;
+	    ok = put_bytes(fp, (long_u)p->sst_lnum, 4) == OK
+		    && put_bytes(fp, (long_u)p->sst_next_flags, 4) == OK
+		    && put_bytes(fp, (long_u)p->sst_stacksize, 4) == OK;
+	    if (p->sst_stacksize > SST_FIX_STATES)
+		bp = SYN_STATE_P(&(p->sst_union.sst_ga));
+	    else
+		bp = p->sst_union.sst_stack;
+	    for (i = 0; ok && i < p->sst_stacksize; ++i)
+		ok = put_bytes(fp, (long_u)(bp[i].bs_idx + 1), 4) == OK
+			&& put_bytes(fp, (long_u)bp[i].bs_flags, 4) == OK
+#ifdef FEAT_CONCEAL
+			&& put_bytes(fp, (long_u)bp[i].bs_seqnr, 4) == OK
+			&& put_bytes(fp, (long_u)bp[i].bs_cchar, 4) == OK;
+#else
+			&& put_bytes(fp, (long_u)0, 4) == OK
+			&& put_bytes(fp, (long_u)0, 4) == OK;
+#endif
+	}
+	if (fclose(fp) != 0)
+	    ok = FALSE;
+	if (!ok)
+	    mch_remove(file_name);
+    }
+    vim_free(file_name);
+}
+
+/*
+ * Read the syntax states for syn_buf from the cache file, if it was written
+ * for the same text and the same syntax items.  Only called when there are no
+ * states yet.
+ */
+    static void
+syn_cache_read()
+{
+    synblock_T	*block = syn_block;
+    buf_T	*buf = syn_buf;
+    char_u	*file_name;
+    FILE	*fp;
+    char_u	magic_buf[SYC_MAGIC_LEN];
+    char_u	read_hash[UNDO_HASH_SIZE];
+    char_u	hash[UNDO_HASH_SIZE];
+    garray_T	items;
+    bufstate_T	*bp;
+    synstate_T	*p;
+    synstate_T	*last = NULL;
+    linenr_T	lnum;
+    linenr_T	prev_lnum = 0;
+    int		next_flags;
+    int		stacksize;
+    long	count;
+    int		i;
+#ifdef FEAT_CONCEAL
+    int		seqnr_base = next_seqnr;
+    int		seqnr_max = 0;
+#endif
+
+    block->b_sst_cache_tried = TRUE;
+    if (block != &buf->b_s || !syn_cache_useful(buf))
+	return;
+    file_name = u_get_cache_file_name(buf->b_ffname, TRUE, SYC_EXT);
+    if (file_name == NULL)
+	return;
+    fp = mch_fopen((char *)file_name, READBIN);
+    if (fp == NULL)
+    {
+	vim_free(file_name);
+	return;
+    }
+    if (p_verbose > 0)
+    {
+	verbose_enter();
+	smsg((char_u *)_("Reading syntax cache: %s"), file_name);
+	verbose_leave();
+    }
+
+    /* Check that the states were computed for this text and these syntax
+     * items, otherwise they are useless. */
+    if (fread(magic_buf, (size_t)SYC_MAGIC_LEN, (size_t)1, fp) != 1
+	    || memcmp(magic_buf, SYC_MAGIC, SYC_MAGIC_LEN) != 0
+	    || get2c(fp) != SYC_VERSION
+	    || fread(read_hash, (size_t)UNDO_HASH_SIZE, (size_t)1, fp) != 1
+	    || get4c(fp) != buf->b_ml.ml_line_count)
+	goto theend;
+    u_compute_buf_hash(buf, hash);
+    if (memcmp(hash, read_hash, UNDO_HASH_SIZE) != 0
+	    || fread(read_hash, (size_t)UNDO_HASH_SIZE, (size_t)1, fp) != 1)
+	goto theend;
+    syn_cache_syntax_hash(buf, hash);
+    if (memcmp(hash, read_hash, UNDO_HASH_SIZE) != 0)
+	goto theend;
+
+    /* Keep enough free entries for the displayed lines. */
+    ga_init2(&items, (int)sizeof(bufstate_T), 10);
+    for (count = get4c(fp); count > 0 && block->b_sst_freecount > Rows;
+								     --count)
+    {
+	lnum = get4c(fp);
+	next_flags = get4c(fp);
+	stacksize = get4c(fp);
+	if (feof(fp) || lnum <= prev_lnum || lnum > buf->b_ml.ml_line_count
+		|| stacksize < 0 || stacksize > SYC_MAX_STACK
+		|| ga_grow(&items, stacksize) == FAIL)
+	    break;
+	bp = (bufstate_T *)items.ga_data;
+	for (i = 0; i < stacksize; ++i)
+	{
+	    bp[i].bs_idx = get4c(fp) - 1;
+	    bp[i].bs_flags = get4c(fp);
+#ifdef FEAT_CONCEAL
+	    bp[i].bs_seqnr = get4c(fp);
+	    bp[i].bs_cchar = get4c(fp);
+	    if (bp[i].bs_seqnr < 0 || bp[i].bs_seqnr >= MAXCOL - seqnr_base
+		    || bp[i].bs_cchar < 0)
+		break;
+	    if (bp[i].bs_seqnr > seqnr_max)
+		seqnr_max = bp[i].bs_seqnr;
+	    bp[i].bs_seqnr += seqnr_base;
+#else
+	    (void)get4c(fp);
+	    (void)get4c(fp);
+#endif
+	    bp[i].bs_extmatch = NULL;
+	    if (bp[i].bs_idx < 0
+		    || bp[i].bs_idx >= block->b_syn_patterns.ga_len)
+		break;
+	}
+	if (i < stacksize || feof(fp))
+	    break;
+
+	/* Take the first item from the free list and append it to the used
+	 * list. */
+	p = block->b_sst_firstfree;
+	block->b_sst_firstfree = p->sst_next;
+	--block->b_sst_freecount;
+	p->sst_next = NULL;
+	if (last == NULL)
+	    block->b_sst_first = p;
+	else
+	    last->sst_next = p;
+	last = p;
+
+	p->sst_lnum = lnum;
+	p->sst_stacksize = stacksize;
+	if (stacksize > SST_FIX_STATES)
+	{
+	    /* Hand over the growarray, start a new one for the next state. */
+	    items.ga_len = stacksize;
+	    p->sst_union.sst_ga = items;
+	    ga_init2(&items, (int)sizeof(bufstate_T), 10);
+	}
+	else
+	    mch_memmove(p->sst_union.sst_stack, bp,
+					      stacksize * sizeof(bufstate_T));
+	p->sst_next_flags = next_flags;
+	p->sst_next_list = NULL;
+	p->sst_tick = display_tick;
+	p->sst_change_lnum = 0;
+	prev_lnum = lnum;
+    }
+    ga_clear(&items);
+#ifdef FEAT_CONCEAL
+    next_seqnr = seqnr_base + seqnr_max + 1;
+#endif
+
+    /* No need to write the file again for these states. */
+    block->b_sst_cache_tick = buf->b_changedtick;
+    block->b_sst_cache_lnum = prev_lnum;
+
+theend:
+    fclose(fp);
+    vim_free(file_name);
+}
+#endif
+
 /*
  * Reduce the number of entries in the state stack for syn_buf.
  * Returns TRUE if at least one entry was freed.
@@ -1816,7 +2511,11 @@ get_syntax_attr(col, can_spell, keep_state)
     int		keep_state;	/* keep state of char at "col" */
 {
     int	    attr = 0;
+    int	    spell;
+    synattr_line_T *sal;
 
+    if (syn_attr_store != NULL && can_spell == NULL)
+	can_spell = &spell;	/* store it for when it's needed later */
     if (can_spell != NULL)
 	/* Default: Only do spelling when there is no @Spell cluster or when
 	 * ":syn spell toplevel" was used. */
@@ -1842,6 +2541,26 @@ get_syntax_attr(col, can_spell, keep_state)
 	return 0;
     }
 
+    if (syn_attr_replay != NULL)
+    {
+	if (col < syn_attr_replay->sal_col)
+	    return syn_attr_replay_col(col, can_spell);
+
+	/* Not stored this far: parse the line after all and store it again. */
+	sal = syn_attr_replay;
+	syntax_start(syn_win, sal->sal_lnum);
+	if (syn_block->b_sst_array == NULL)
+	    return 0;
+	if (!got_int)
+	{
+	    sal->sal_col = 0;
+	    sal->sal_runs.ga_len = 0;
+	    syn_attr_store = sal;
+	    if (can_spell == NULL)
+		can_spell = &spell;
+	}
+    }
+
     /* Make sure current_state is valid */
     if (INVALID_STATE(&current_state))
 	validate_current_state();
@@ -1853,12 +2572,113 @@ get_syntax_attr(col, can_spell, keep_state)
     {
 	attr = syn_current_attr(FALSE, TRUE, can_spell,
 				     current_col == col ? keep_state : FALSE);
+	if (syn_attr_store != NULL)
+	    syn_attr_store_col(attr, *can_spell);
 	++current_col;
     }
 
     return attr;
 }
 
+/*
+ * Store the attributes for current_col in the line being stored.
+ */
+    static void
+syn_attr_store_col(attr, can_spell)
+    int		attr;
+    int		can_spell;
+{
+    synattr_line_T	*sal = syn_attr_store;
+    synattr_run_T	*run;
+    synattr_run_T	new_run;
+
+    if (current_col != sal->sal_col)
+    {
+	/* not parsing column by column, can't store this */
+	syn_attr_store = NULL;
+	return;
+    }
+
+    vim_memset(&new_run, 0, sizeof(new_run));
+    new_run.sar_endcol = current_col;
+    new_run.sar_attr = attr;
+    new_run.sar_can_spell = can_spell;
+#ifdef FEAT_EVAL
+    new_run.sar_id = current_id;
+    new_run.sar_trans_id = current_trans_id;
+#endif
+#ifdef FEAT_CONCEAL
+    new_run.sar_flags = current_flags;
+    new_run.sar_seqnr = current_seqnr;
+    new_run.sar_sub_char = current_sub_char;
+#endif
+
+    run = sal->sal_runs.ga_len == 0 ? NULL
+	  : (synattr_run_T *)sal->sal_runs.ga_data + sal->sal_runs.ga_len - 1;
+    if (run != NULL)
+    {
+	/* Extend the last run when the attributes are equal. */
+	new_run.sar_endcol = run->sar_endcol;
+	if (memcmp(run, &new_run, sizeof(new_run)) == 0)
+	{
+	    run->sar_endcol = current_col;
+	    ++sal->sal_col;
+	    return;
+	}
+	new_run.sar_endcol = current_col;
+    }
+    if (sal->sal_runs.ga_len >= SYN_ATTR_RUNS
+				       || ga_grow(&sal->sal_runs, 1) == FAIL)
+    {
+	/* Keep the columns stored so far. */
+	syn_attr_store = NULL;
+	return;
+    }
+    ((synattr_run_T *)sal->sal_runs.ga_data)[sal->sal_runs.ga_len++] =
+								      new_run;
+    ++sal->sal_col;
+}
+
+/*
+ * Get the attributes for column "col" from the line being redrawn, as if
+ * the line was parsed.
+ */
+    static int
+syn_attr_replay_col(col, can_spell)
+    colnr_T	col;
+    int		*can_spell;
+{
+    synattr_run_T	*runs = (synattr_run_T *)syn_attr_replay->sal_runs.ga_data;
+    synattr_run_T	*run;
+    int			bot = 0;
+    int			top = syn_attr_replay->sal_runs.ga_len - 1;
+    int			i;
+
+    /* Binary search for the run that includes "col". */
+    while (bot < top)
+    {
+	i = (bot + top) / 2;
+	if (runs[i].sar_endcol < col)
+	    bot = i + 1;
+	else
+	    top = i;
+    }
+    run = &runs[bot];
+
+    if (can_spell != NULL)
+	*can_spell = run->sar_can_spell;
+#ifdef FEAT_EVAL
+    current_id = run->sar_id;
+    current_trans_id = run->sar_trans_id;
+#endif
+#ifdef FEAT_CONCEAL
+    current_flags = run->sar_flags;
+    current_seqnr = run->sar_seqnr;
+    current_sub_char = run->sar_sub_char;
+#endif
+    return run->sar_attr;
+}
+
 /*
  * Get syntax attributes for current_lnum, current_col.
  */
@@ -2086,14 +2906,28 @@ syn_current_attr(syncing, displaying, can_spell, keep_state)
 			    if (spp->sp_line_id == current_line_id
 				    && spp->sp_startcol >= next_match_col)
 				continue;
-			    spp->sp_line_id = current_line_id;
+
+			    regmatch.rmm_ic = spp->sp_ic;
+			    regmatch.regprog = spp->sp_prog;
+
+			    /* The first time in this line quickly check if the
+			     * pattern can match anywhere in it.  Most patterns
+			     * can't, this avoids a lot of slow matching. */
+			    if (spp->sp_line_id != current_line_id)
+			    {
+				spp->sp_line_id = current_line_id;
+				if (!vim_regline_may_match(&regmatch, syn_buf,
+								current_lnum))
+				{
+				    spp->sp_startcol = MAXCOL;
+				    continue;
+				}
+			    }
 
 			    lc_col = current_col - spp->sp_offsets[SPO_LC_OFF];
 			    if (lc_col < 0)
 				lc_col = 0;
 
-			    regmatch.rmm_ic = spp->sp_ic;
-			    regmatch.regprog = spp->sp_prog;
 			    r = syn_regexec(&regmatch,
 					     current_lnum,
 					     (colnr_T)lc_col,
@@ -3289,7 +4123,10 @@ syn_regexec(rmp, lnum, col, st)
 	profile_end(&pt);
 	profile_add(&st->total, &pt);
 	if (profile_cmp(&pt, &st->slowest) < 0)
+	{
 	    st->slowest = pt;
+	    st->slowest_lnum = lnum;
+	}
 	++st->count;
 	if (r > 0)
 	    ++st->match;
@@ -6449,7 +7286,9 @@ syn_get_id(wp, lnum, col, trans, spellp, keep_state)
 {
     /* When the position is not after the current position and in the same
      * line of the same buffer, need to restart parsing. */
-    if (wp->w_buffer != syn_buf
+    syn_attr_store = NULL;
+    if (syn_attr_replay != NULL
+	    || wp->w_buffer != syn_buf
 	    || lnum != current_lnum
 	    || col < current_col)
 	syntax_start(wp, lnum);
@@ -6541,20 +7380,58 @@ syn_get_foldlevel(wp, lnum)
 /*
  * ":syntime".
  */
+static char *(syntime_sort_names[]) =
+		  {"total", "count", "match", "slowest", "average", "name", NULL};
+
     void
 ex_syntime(eap)
     exarg_T	*eap;
 {
-    if (STRCMP(eap->arg, "on") == 0)
+    char_u	*arg = eap->arg;
+    char_u	*e = skiptowhite(arg);
+    int		len = (int)(e - arg);
+    int		i;
+
+    e = skipwhite(e);
+    if (len == 2 && STRNCMP(arg, "on", 2) == 0 && *e == NUL)
+    {
 	syn_time_on = TRUE;
-    else if (STRCMP(eap->arg, "off") == 0)
+	/* Don't use stored attributes, the lines must be parsed to measure. */
+	++linecache_tick;
+    }
+    else if (len == 3 && STRNCMP(arg, "off", 3) == 0 && *e == NUL)
 	syn_time_on = FALSE;
-    else if (STRCMP(eap->arg, "clear") == 0)
+    else if (len == 5 && STRNCMP(arg, "clear", 5) == 0 && *e == NUL)
 	syntime_clear();
-    else if (STRCMP(eap->arg, "report") == 0)
+    else if (len == 6 && STRNCMP(arg, "report", 6) == 0)
+    {
+	/* ":syntime report {sort}" */
+	if (*e != NUL)
+	{
+	    for (i = 0; syntime_sort_names[i] != NULL; ++i)
+		if (STRCMP(e, syntime_sort_names[i]) == 0)
+		    break;
+	    if (syntime_sort_names[i] == NULL)
+	    {
+		EMSG2(_(e_invarg2), e);
+		return;
+	    }
+	    syn_time_sort = i;
+	}
 	syntime_report();
+    }
+    else if (len == 5 && STRNCMP(arg, "write", 5) == 0 && *e != NUL)
+    {
+	/* ":syntime write {fname}" */
+	e = expand_env_save_opt(e, TRUE);
+	if (e != NULL)
+	{
+	    syntime_write(e);
+	    vim_free(e);
+	}
+    }
     else
-	EMSG2(_(e_invarg2), eap->arg);
+	EMSG2(_(e_invarg2), arg);
 }
 
     static void
@@ -6563,6 +7440,7 @@ syn_clear_time(st)
 {
     profile_zero(&st->total);
     profile_zero(&st->slowest);
+    st->slowest_lnum = 0;
     st->count = 0;
     st->match = 0;
 }
@@ -6604,6 +7482,7 @@ get_syntime_arg(xp, idx)
 	case 1: return (char_u *)"off";
 	case 2: return (char_u *)"clear";
 	case 3: return (char_u *)"report";
+	case 4: return (char_u *)"write";
     }
     return NULL;
 }
@@ -6612,9 +7491,10 @@ get_syntime_arg(xp, idx)
 typedef struct
 {
     proftime_T	total;
-    int		count;
-    int		match;
+    long	count;
+    long	match;
     proftime_T	slowest;
+    linenr_T	slowest_lnum;
     proftime_T	average;
     int		id;
     char_u	*pattern;
@@ -6630,67 +7510,107 @@ syn_compare_syntime(v1, v2)
 {
     const time_entry_T	*s1 = v1;
     const time_entry_T	*s2 = v2;
+    int			r = 0;
 
-    return profile_cmp(&s1->total, &s2->total);
+    /* Largest numbers first, group names alphabetically. */
+    switch (syn_time_sort)
+    {
+	case 1: r = s1->count == s2->count ? 0
+					  : s1->count > s2->count ? -1 : 1;
+		break;
+	case 2: r = s1->match == s2->match ? 0
+					  : s1->match > s2->match ? -1 : 1;
+		break;
+	case 3: r = profile_cmp(&s1->slowest, &s2->slowest);
+		break;
+	case 4: r = profile_cmp(&s1->average, &s2->average);
+		break;
+	case 5: r = STRICMP(HL_TABLE()[s1->id - 1].sg_name,
+					       HL_TABLE()[s2->id - 1].sg_name);
+		break;
+    }
+    if (r == 0)
+	r = profile_cmp(&s1->total, &s2->total);
+    return r;
 }
 
 /*
- * Clear the syntax timing for the current buffer.
+ * Get the timing of the syntax patterns of the current window in "gap",
+ * sorted as specified with syn_time_sort.  Also returns the total time and
+ * count.  Returns FAIL when there are no syntax items.
  */
-    static void
-syntime_report()
+    static int
+syntime_collect(gap, total, count)
+    garray_T	*gap;
+    proftime_T	*total;
+    long	*count;
 {
     int		idx;
     synpat_T	*spp;
+    time_entry_T *p;
 # ifdef FEAT_FLOAT
     proftime_T	tm;
 # endif
-    int		len;
-    proftime_T	total_total;
-    int		total_count = 0;
-    garray_T    ga;
-    time_entry_T *p;
 
     if (!syntax_present(curwin))
     {
 	MSG(_(msg_no_items));
-	return;
+	return FAIL;
     }
 
-    ga_init2(&ga, sizeof(time_entry_T), 50);
-    profile_zero(&total_total);
+    ga_init2(gap, sizeof(time_entry_T), 50);
+    profile_zero(total);
+    *count = 0;
     for (idx = 0; idx < curwin->w_s->b_syn_patterns.ga_len; ++idx)
     {
 	spp = &(SYN_ITEMS(curwin->w_s)[idx]);
-	if (spp->sp_time.count > 0)
+	if (spp->sp_time.count > 0 && ga_grow(gap, 1) == OK)
 	{
-	    ga_grow(&ga, 1);
-	    p = ((time_entry_T *)ga.ga_data) + ga.ga_len;
+	    p = ((time_entry_T *)gap->ga_data) + gap->ga_len;
 	    p->total = spp->sp_time.total;
-	    profile_add(&total_total, &spp->sp_time.total);
+	    profile_add(total, &spp->sp_time.total);
 	    p->count = spp->sp_time.count;
 	    p->match = spp->sp_time.match;
-	    total_count += spp->sp_time.count;
+	    *count += spp->sp_time.count;
 	    p->slowest = spp->sp_time.slowest;
+	    p->slowest_lnum = spp->sp_time.slowest_lnum;
 # ifdef FEAT_FLOAT
 	    profile_divide(&spp->sp_time.total, spp->sp_time.count, &tm);
 	    p->average = tm;
+# else
+	    profile_zero(&p->average);
 # endif
 	    p->id = spp->sp_syn.id;
 	    p->pattern = spp->sp_pattern;
-	    ++ga.ga_len;
+	    ++gap->ga_len;
 	}
     }
 
-    /* sort on total time */
-    qsort(ga.ga_data, (size_t)ga.ga_len, sizeof(time_entry_T),
+    qsort(gap->ga_data, (size_t)gap->ga_len, sizeof(time_entry_T),
 							 syn_compare_syntime);
+    return OK;
+}
 
-    MSG_PUTS_TITLE(_("  TOTAL      COUNT  MATCH   SLOWEST     AVERAGE   NAME               PATTERN"));
+/*
+ * Display the syntax timing for the current buffer.
+ */
+    static void
+syntime_report()
+{
+    int		idx;
+    int		len;
+    proftime_T	total_total;
+    long	total_count;
+    garray_T    ga;
+    time_entry_T *p;
+
+    if (syntime_collect(&ga, &total_total, &total_count) == FAIL)
+	return;
+
+    MSG_PUTS_TITLE(_("  TOTAL      COUNT  MATCH   SLOWEST     LINE   AVERAGE   NAME               PATTERN"));
     MSG_PUTS("\n");
     for (idx = 0; idx < ga.ga_len && !got_int; ++idx)
     {
-	spp = &(SYN_ITEMS(curwin->w_s)[idx]);
 	p = ((time_entry_T *)ga.ga_data) + idx;
 
 	MSG_PUTS(profile_msg(&p->total));
@@ -6705,19 +7625,22 @@ syntime_report()
 	MSG_PUTS(profile_msg(&p->slowest));
 	MSG_PUTS(" ");
 	msg_advance(38);
+	msg_outnum((long)p->slowest_lnum);
+	MSG_PUTS(" ");
+	msg_advance(45);
 # ifdef FEAT_FLOAT
 	MSG_PUTS(profile_msg(&p->average));
 	MSG_PUTS(" ");
 # endif
-	msg_advance(50);
+	msg_advance(57);
 	msg_outtrans(HL_TABLE()[p->id - 1].sg_name);
 	MSG_PUTS(" ");
 
-	msg_advance(69);
-	if (Columns < 80)
+	msg_advance(76);
+	if (Columns < 87)
 	    len = 20; /* will wrap anyway */
 	else
-	    len = Columns - 70;
+	    len = Columns - 77;
 	if (len > (int)STRLEN(p->pattern))
 	    len = (int)STRLEN(p->pattern);
 	msg_outtrans_len(p->pattern, len);
@@ -6733,6 +7656,49 @@ syntime_report()
 	MSG_PUTS("\n");
     }
 }
+
+/*
+ * Write the syntax timing for the current buffer to file "fname", one line
+ * per pattern with the fields separated by a Tab, sorted like for
+ * ":syntime report".
+ */
+    static void
+syntime_write(fname)
+    char_u	*fname;
+{
+    int		idx;
+    proftime_T	total_total;
+    long	total_count;
+    garray_T    ga;
+    time_entry_T *p;
+    FILE	*fd;
+
+    if (syntime_collect(&ga, &total_total, &total_count) == FAIL)
+	return;
+
+    fd = mch_fopen((char *)fname, "w");
+    if (fd == NULL)
+	EMSG2(_(e_notopen), fname);
+    else
+    {
+	fputs("total\tcount\tmatch\tslowest\tline\taverage\tname\tpattern\n", fd);
+	for (idx = 0; idx < ga.ga_len; ++idx)
+	{
+	    p = ((time_entry_T *)ga.ga_data) + idx;
+	    fprintf(fd, "%s\t", skipwhite((char_u *)profile_msg(&p->total)));
+	    fprintf(fd, "%ld\t%ld\t", p->count, p->match);
+	    fprintf(fd, "%s\t", skipwhite((char_u *)profile_msg(&p->slowest)));
+	    fprintf(fd, "%ld\t", (long)p->slowest_lnum);
+	    fprintf(fd, "%s\t", skipwhite((char_u *)profile_msg(&p->average)));
+	    fprintf(fd, "%s\t%s\n", HL_TABLE()[p->id - 1].sg_name,
+								  p->pattern);
+	}
+	fprintf(fd, "%s\t%ld\n", skipwhite((char_u *)profile_msg(&total_total)),
+								 total_count);
+	fclose(fd);
+    }
+    ga_clear(&ga);
+}
 #endif
 
 #endif /* FEAT_SYN_HL */
@@ -7243,6 +8209,10 @@ do_highlight(line, forceit, init)
 #ifdef FEAT_EVAL
 		HL_TABLE()[from_id - 1].sg_scriptID = current_SID;
 #endif
+#ifdef FEAT_SYN_HL
+		++syn_attr_hl_tick;
+#endif
+		++linecache_tick;
 		redraw_all_later(SOME_VALID);
 	    }
 	}
@@ -8590,6 +9560,10 @@ clear_hl_tables()
     int		i;
     attrentry_T	*taep;
 
+#ifdef FEAT_SYN_HL
+    ++syn_attr_hl_tick;		/* attribute numbers will change */
+#endif
+    ++linecache_tick;
 #ifdef FEAT_GUI
     ga_clear(&gui_attr_table);
 #endif
@@ -9100,6 +10074,11 @@ set_hl_attr(idx)
     attrentry_T		at_en;
     struct hl_group	*sgp = HL_TABLE() + idx;
 
+#ifdef FEAT_SYN_HL
+    ++syn_attr_hl_tick;		/* cached syntax attributes may be wrong */
+#endif
+    ++linecache_tick;		/* and so may drawn lines */
+
     /* The "Normal" group doesn't need an attribute number */
     if (sgp->sg_name_u != NULL && STRCMP(sgp->sg_name_u, "NORMAL") == 0)
 	return;
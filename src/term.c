@@ -1240,6 +1240,13 @@ static struct builtin_term builtin_termcaps[] =
 #  endif
     {(int)KS_CRV,	"[CRV]"},
     {(int)KS_U7,	"[U7]"},
+#  ifdef TERMINFO
+    {(int)KS_RP,	"[%p1%cRP%p2%d]"},
+#  else
+    {(int)KS_RP,	"[%.RP%d]"},
+#  endif
+    {(int)KS_CBS,	"[CBS]"},
+    {(int)KS_CES,	"[CES]"},
     {K_UP,		"[KU]"},
     {K_DOWN,		"[KD]"},
     {K_LEFT,		"[KL]"},
@@ -1615,7 +1622,7 @@ set_termname(term)
 				{KS_TS, "ts"}, {KS_FS, "fs"},
 				{KS_CWP, "WP"}, {KS_CWS, "WS"},
 				{KS_CSI, "SI"}, {KS_CEI, "EI"},
-				{KS_U7, "u7"},
+				{KS_U7, "u7"}, {KS_RP, "rp"},
 				{(enum SpecialKey)0, NULL}
 			    };
 
@@ -2510,6 +2517,41 @@ termcapinit(name)
 static char_u		out_buf[OUT_SIZE + 1];
 static int		out_pos = 0;	/* number of chars in out_buf */
 
+/*
+ * While redrawing with t_BS set the output of the whole frame is collected in
+ * "out_frame_ga" and written with one ui_write() when the frame has ended.
+ */
+static garray_T		out_frame_ga = {0, 0, 1, (OUT_SIZE + 1) * 8, NULL};
+static int		out_in_frame = FALSE;
+
+/* Counters for redrawstats(). */
+static long		out_bytes = 0;	    /* bytes written */
+static long		out_writes = 0;	    /* calls to ui_write() */
+static long		out_frames = 0;	    /* number of screen updates */
+static long		out_frame_bytes = 0;  /* out_bytes when frame started */
+static long		out_frame_writes = 0; /* out_writes when frame started */
+static int		out_frame_busy = FALSE;    /* frame being drawn */
+static int		out_frame_pending = FALSE; /* frame output not written */
+static long		out_last_bytes = 0;   /* bytes for the last frame */
+static long		out_last_writes = 0;  /* writes for the last frame */
+
+static void out_write __ARGS((char_u *s, int len));
+static void out_flush_frame __ARGS((void));
+static void out_frame_done __ARGS((void));
+
+/*
+ * Write "len" bytes from "s" and count them.
+ */
+    static void
+out_write(s, len)
+    char_u	*s;
+    int		len;
+{
+    out_bytes += len;
+    ++out_writes;
+    ui_write(s, len);
+}
+
 /*
  * out_flush(): flush the output buffer
  */
@@ -2523,10 +2565,115 @@ out_flush()
 	/* set out_pos to 0 before ui_write, to avoid recursiveness */
 	len = out_pos;
 	out_pos = 0;
-	ui_write(out_buf, len);
+	if ((out_in_frame || out_frame_ga.ga_len > 0)
+				       && ga_grow(&out_frame_ga, len) == OK)
+	{
+	    mch_memmove((char_u *)out_frame_ga.ga_data + out_frame_ga.ga_len,
+							 out_buf, (size_t)len);
+	    out_frame_ga.ga_len += len;
+	}
+	else
+	{
+	    /* out of memory: write what was collected so far first */
+	    out_flush_frame();
+	    out_write(out_buf, len);
+	}
+    }
+    if (!out_in_frame)
+    {
+	out_flush_frame();
+	if (out_frame_pending && !out_frame_busy)
+	    out_frame_done();
+    }
+}
+
+/*
+ * Write the output collected for a frame.
+ */
+    static void
+out_flush_frame()
+{
+    int	    len = out_frame_ga.ga_len;
+
+    if (len > 0)
+    {
+	out_frame_ga.ga_len = 0;
+	out_write((char_u *)out_frame_ga.ga_data, len);
     }
 }
 
+/*
+ * Called before update_screen() draws anything: start a new frame.  When
+ * "t_BS" is set output it and collect all output until term_end_frame().
+ */
+    void
+term_start_frame()
+{
+    if (out_frame_pending)
+	out_frame_done();
+    ++out_frames;
+    out_frame_bytes = out_bytes + out_pos;
+    out_frame_writes = out_writes;
+    out_frame_pending = TRUE;
+    out_frame_busy = TRUE;
+
+    if (*T_CBS != NUL && !out_in_frame && termcap_active && !p_wd
+# ifdef FEAT_GUI
+	    && !gui.in_use
+# endif
+	    )
+    {
+	out_in_frame = TRUE;
+	out_str(T_CBS);
+    }
+}
+
+/*
+ * End the frame started with term_start_frame().  The collected output is
+ * written with the next out_flush().  Also called before waiting for a
+ * character, so that a prompt shown while redrawing is visible.
+ * Returns TRUE when a frame was ended.
+ */
+    int
+term_end_frame()
+{
+    out_frame_busy = FALSE;
+    if (!out_in_frame)
+	return FALSE;
+    out_str(T_CES);
+    out_in_frame = FALSE;
+    return TRUE;
+}
+
+/*
+ * The output of the last frame has been written (or a new frame started):
+ * remember how much it took.
+ */
+    static void
+out_frame_done()
+{
+    out_last_bytes = out_bytes + out_pos - out_frame_bytes;
+    out_last_writes = out_writes - out_frame_writes;
+    out_frame_pending = FALSE;
+}
+
+#if defined(FEAT_EVAL) || defined(PROTO)
+/*
+ * Get the output counters for redrawstats().
+ */
+    void
+term_get_stats(dict)
+    dict_T	*dict;
+{
+    dict_add_nr_str(dict, "redraws", out_frames, NULL);
+    dict_add_nr_str(dict, "bytes", out_bytes, NULL);
+    dict_add_nr_str(dict, "writes", out_writes, NULL);
+    dict_add_nr_str(dict, "lines", redraw_line_count, NULL);
+    dict_add_nr_str(dict, "lastbytes", out_last_bytes, NULL);
+    dict_add_nr_str(dict, "lastwrites", out_last_writes, NULL);
+}
+#endif
+
 #if defined(FEAT_MBYTE) || defined(PROTO)
 /*
  * Sometimes a byte out of a multi-byte character is written with out_char().
@@ -2673,6 +2820,26 @@ term_cursor_right(i)
     OUT_STR(tgoto((char *)T_CRI, 0, i));
 }
 
+/*
+ * Output character "c" "n" times with the repeat code, when that is shorter
+ * than writing the characters.  Returns FAIL when nothing was output.
+ */
+    int
+term_repeat_char(c, n)
+    int	    c;
+    int	    n;
+{
+    char_u  *s;
+
+    if (*T_RP == NUL)
+	return FAIL;
+    s = (char_u *)tgoto((char *)T_RP, n, c);
+    if ((int)STRLEN(s) >= n)
+	return FAIL;
+    OUT_STR(s);
+    return OK;
+}
+
     void
 term_append_lines(line_count)
     int	    line_count;
@@ -3276,6 +3443,7 @@ starttermcap()
     void
 stoptermcap()
 {
+    term_end_frame();
     screen_stop_highlight();
     reset_cterm_colors();
     if (termcap_active)
@@ -3681,6 +3849,10 @@ clear_termcodes()
 #endif
 
     need_gather = TRUE;		/* need to fill termleader[] */
+
+    /* The buffer for a frame is allocated again when needed. */
+    if (out_frame_ga.ga_len == 0)
+	ga_clear(&out_frame_ga);
 }
 
 #define ATC_FROM_TERM 55
@@ -86,10 +86,13 @@ enum SpecialKey
     KS_CSV,	/* scroll region vertical */
 #endif
     KS_OP,	/* original color pair */
-    KS_U7	/* request cursor position */
+    KS_U7,	/* request cursor position */
+    KS_RP,	/* repeat character */
+    KS_CBS,	/* begin synchronized update */
+    KS_CES	/* end synchronized update */
 };
 
-#define KS_LAST	    KS_U7
+#define KS_LAST	    KS_CES
 
 /*
  * the terminal capabilities are stored in this array
@@ -164,6 +167,9 @@ extern char_u *(term_strings[]);    /* current terminal strings */
 #define T_CRV	(term_str(KS_CRV))	/* request version string */
 #define T_OP	(term_str(KS_OP))	/* original color pair */
 #define T_U7	(term_str(KS_U7))	/* request cursor position */
+#define T_RP	(term_str(KS_RP))	/* repeat character */
+#define T_CBS	(term_str(KS_CBS))	/* begin synchronized update */
+#define T_CES	(term_str(KS_CES))	/* end synchronized update */
 
 #define TMODE_COOK  0	/* terminal mode for external cmds and Ex mode */
 #define TMODE_SLEEP 1	/* terminal mode for sleeping (cooked but no echo) */
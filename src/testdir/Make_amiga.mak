@@ -46,6 +46,7 @@ SCRIPTS = test1.out test3.out test4.out test5.out test6.out \
 		test_erasebackword.out \
 		test_eval.out \
 		test_insertcount.out \
+		test_linecache.out \
 		test_listchars.out \
 		test_listlbr.out \
 		test_listlbr_utf8.out \
@@ -54,9 +55,21 @@ SCRIPTS = test1.out test3.out test4.out test5.out test6.out \
 		test_nested_function.out \
 		test_options.out \
 		test_qf_title.out \
+		test_readfile_nul.out \
+		test_redraw_lines.out \
+		test_redrawstats.out \
+		test_regcache.out \
+		test_regexp_adapt.out \
+		test_regexp_coll.out \
+		test_regexp_dfa.out \
+		test_regexp_must.out \
 		test_signs.out \
+		test_syntax_attr.out \
+		test_syntaxcache.out \
+		test_syntime.out \
 		test_textobjects.out \
-		test_utf8.out
+		test_utf8.out \
+		test_virtcol_long.out
 
 .SUFFIXES: .in .out
 
@@ -190,6 +203,7 @@ test_command_count.out: test_command_count.in
 test_erasebackword.out: test_erasebackword.in
 test_eval.out: test_eval.in
 test_insertcount.out: test_insertcount.in
+test_linecache.out: test_linecache.in
 test_listchars.out: test_listchars.in
 test_listlbr.out: test_listlbr.in
 test_listlbr_utf8.out: test_listlbr_utf8.in
@@ -198,6 +212,18 @@ test_marks.out: test_marks.in
 test_nested_function.out: test_nested_function.in
 test_options.out: test_options.in
 test_qf_title.out: test_qf_title.in
+test_readfile_nul.out: test_readfile_nul.in
+test_redraw_lines.out: test_redraw_lines.in
+test_redrawstats.out: test_redrawstats.in
+test_regcache.out: test_regcache.in
+test_regexp_adapt.out: test_regexp_adapt.in
+test_regexp_coll.out: test_regexp_coll.in
+test_regexp_dfa.out: test_regexp_dfa.in
+test_regexp_must.out: test_regexp_must.in
 test_signs.out: test_signs.in
+test_syntax_attr.out: test_syntax_attr.in
+test_syntaxcache.out: test_syntaxcache.in
+test_syntime.out: test_syntime.in
 test_textobjects.out: test_textobjects.in
 test_utf8.out: test_utf8.in
+test_virtcol_long.out: test_virtcol_long.in
@@ -45,6 +45,7 @@ SCRIPTS =	test3.out test4.out test5.out test6.out test7.out \
 		test_erasebackword.out \
 		test_eval.out \
 		test_insertcount.out \
+		test_linecache.out \
 		test_listchars.out \
 		test_listlbr.out \
 		test_listlbr_utf8.out \
@@ -53,9 +54,21 @@ SCRIPTS =	test3.out test4.out test5.out test6.out test7.out \
 		test_nested_function.out \
 		test_options.out \
 		test_qf_title.out \
+		test_readfile_nul.out \
+		test_redraw_lines.out \
+		test_redrawstats.out \
+		test_regcache.out \
+		test_regexp_adapt.out \
+		test_regexp_coll.out \
+		test_regexp_dfa.out \
+		test_regexp_must.out \
 		test_signs.out \
+		test_syntax_attr.out \
+		test_syntaxcache.out \
+		test_syntime.out \
 		test_textobjects.out \
-		test_utf8.out
+		test_utf8.out \
+		test_virtcol_long.out
 
 SCRIPTS32 =	test50.out test70.out
 
@@ -149,6 +149,11 @@ ui_inchar(buf, maxlen, wtime, tb_change_cnt)
 	prof_inchar_enter();
 #endif
 
+    /* When waiting for a character while redrawing (e.g., at a hit-enter
+     * prompt) the output collected so far must be written. */
+    if (wtime != 0 && term_end_frame())
+	out_flush();
+
 #ifdef NO_CONSOLE_INPUT
     /* Don't wait for character input when the window hasn't been opened yet.
      * Do try reading, this works when redirecting stdin from a file.
@@ -172,6 +177,13 @@ ui_inchar(buf, maxlen, wtime, tb_change_cnt)
     }
 #endif
 
+#ifdef FEAT_SYN_HL
+    /* Use the time until the user types something to compute syntax states
+     * further down the buffer. */
+    if (wtime == -1)
+	syn_idle_update();
+#endif
+
     /* If we are going to wait for some time or block... */
     if (wtime == -1 || wtime > 100L)
     {
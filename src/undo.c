@@ -751,18 +751,50 @@ static char_u e_not_open[] = N_("E828: Cannot open undo file for writing: %s");
     void
 u_compute_hash(hash)
     char_u *hash;
+{
+    u_compute_buf_hash(curbuf, hash);
+}
+
+/*
+ * Compute the hash for the text in buffer "buf".  Uses the hash remembered
+ * with u_set_buf_hash() when the text did not change since then.
+ */
+    void
+u_compute_buf_hash(buf, hash)
+    buf_T	*buf;
+    char_u	*hash;
 {
     context_sha256_T	ctx;
     linenr_T		lnum;
     char_u		*p;
 
+    if (buf->b_u_hash_valid && buf->b_u_hash_tick == buf->b_changedtick)
+    {
+	mch_memmove(hash, buf->b_u_hash, UNDO_HASH_SIZE);
+	return;
+    }
     sha256_start(&ctx);
-    for (lnum = 1; lnum <= curbuf->b_ml.ml_line_count; ++lnum)
+    for (lnum = 1; lnum <= buf->b_ml.ml_line_count; ++lnum)
     {
-	p = ml_get(lnum);
+	p = ml_get_buf(buf, lnum, FALSE);
 	sha256_update(&ctx, p, (UINT32_T)(STRLEN(p) + 1));
     }
     sha256_finish(&ctx, hash);
+    u_set_buf_hash(buf, hash);
+}
+
+/*
+ * Remember "hash" as the hash of the text in buffer "buf", until the text is
+ * changed.
+ */
+    void
+u_set_buf_hash(buf, hash)
+    buf_T	*buf;
+    char_u	*hash;
+{
+    mch_memmove(buf->b_u_hash, hash, UNDO_HASH_SIZE);
+    buf->b_u_hash_valid = TRUE;
+    buf->b_u_hash_tick = buf->b_changedtick;
 }
 
 /*
@@ -776,6 +808,20 @@ u_compute_hash(hash)
 u_get_undo_file_name(buf_ffname, reading)
     char_u	*buf_ffname;
     int		reading;
+{
+    return u_get_cache_file_name(buf_ffname, reading, NULL);
+}
+
+/*
+ * Like u_get_undo_file_name(), but for another file kept next to the undo
+ * file.  "ext" is appended to the name, e.g. "dir/name" -> "dir/.name.ext".
+ * When "ext" is NULL the undo file name is returned.
+ */
+    char_u *
+u_get_cache_file_name(buf_ffname, reading, ext)
+    char_u	*buf_ffname;
+    int		reading;
+    char	*ext;
 {
     char_u	*dirp;
     char_u	dir_name[IOSIZE + 1];
@@ -809,7 +855,8 @@ u_get_undo_file_name(buf_ffname, reading)
 	{
 	    /* Use same directory as the ffname,
 	     * "dir/name" -> "dir/.name.un~" */
-	    undo_file_name = vim_strnsave(ffname, (int)(STRLEN(ffname) + 5));
+	    undo_file_name = vim_strnsave(ffname, (int)(STRLEN(ffname) + 5
+					  + (ext == NULL ? 0 : STRLEN(ext))));
 	    if (undo_file_name == NULL)
 		break;
 	    p = gettail(undo_file_name);
@@ -819,13 +866,14 @@ u_get_undo_file_name(buf_ffname, reading)
 	     * at the beginning to keep the extension */
 	    mch_memmove(p + 4,  p, STRLEN(p) + 1);
 	    mch_memmove(p, "_un_", 4);
-
+	    if (ext != NULL)
+		STRCAT(p, ext);
 #else
 	    /* Use same directory as the ffname,
 	     * "dir/name" -> "dir/.name.un~" */
 	    mch_memmove(p + 1, p, STRLEN(p) + 1);
 	    *p = '.';
-	    STRCAT(p, ".un~");
+	    STRCAT(p, ext == NULL ? ".un~" : ext);
 #endif
 	}
 	else
@@ -843,6 +891,12 @@ u_get_undo_file_name(buf_ffname, reading)
 			    *p = '%';
 		}
 		undo_file_name = concat_fnames(dir_name, munged_name, TRUE);
+		if (undo_file_name != NULL && ext != NULL)
+		{
+		    p = concat_str(undo_file_name, (char_u *)ext);
+		    vim_free(undo_file_name);
+		    undo_file_name = p;
+		}
 	    }
 	}
 
@@ -858,6 +912,73 @@ u_get_undo_file_name(buf_ffname, reading)
     return undo_file_name;
 }
 
+/*
+ * Create the undo file or another file kept next to it, "file_name", for
+ * buffer "buf".  It must not exist, a symlink is not followed.  If the buffer
+ * has a name use the permission of the original file.  Otherwise only allow
+ * the user to access the file.
+ * Returns the file descriptor, -1 when the file can't be created.
+ */
+    int
+u_create_cache_file(buf, file_name)
+    buf_T	*buf;
+    char_u	*file_name;
+{
+    int		fd;
+    int		perm;
+#ifdef UNIX
+    int		st_old_valid = FALSE;
+    struct stat	st_old;
+    struct stat	st_new;
+#endif
+
+    perm = 0600;
+    if (buf->b_ffname != NULL)
+    {
+#ifdef UNIX
+	if (mch_stat((char *)buf->b_ffname, &st_old) >= 0)
+	{
+	    perm = st_old.st_mode;
+	    st_old_valid = TRUE;
+	}
+#else
+	perm = mch_getperm(buf->b_ffname);
+	if (perm < 0)
+	    perm = 0600;
+#endif
+    }
+
+    /* strip any s-bit and executable bit */
+    perm = perm & 0666;
+
+    fd = mch_open((char *)file_name,
+			    O_CREAT|O_EXTRA|O_WRONLY|O_EXCL|O_NOFOLLOW, perm);
+    if (fd < 0)
+	return -1;
+    (void)mch_setperm(file_name, perm);
+
+#ifdef UNIX
+    /*
+     * Try to set the group of the file same as the original file. If
+     * this fails, set the protection bits for the group same as the
+     * protection bits for others.
+     */
+    if (st_old_valid
+	    && mch_stat((char *)file_name, &st_new) >= 0
+	    && st_new.st_gid != st_old.st_gid
+# ifdef HAVE_FCHOWN  /* sequent-ptx lacks fchown() */
+	    && fchown(fd, (uid_t)-1, st_old.st_gid) != 0
+# endif
+       )
+	mch_setperm(file_name, (perm & 0707) | ((perm & 07) << 3));
+# if defined(HAVE_SELINUX) || defined(HAVE_SMACK)
+    if (buf->b_ffname != NULL)
+	mch_copy_sec(buf->b_ffname, file_name);
+# endif
+#endif
+    return fd;
+}
+
     static void
 corruption_error(mesg, file_name)
     char *mesg;
@@ -1564,13 +1685,7 @@ u_write_undo(name, forceit, buf, hash)
 #endif
     int		fd;
     FILE	*fp = NULL;
-    int		perm;
     int		write_ok = FALSE;
-#ifdef UNIX
-    int		st_old_valid = FALSE;
-    struct stat	st_old;
-    struct stat	st_new;
-#endif
     bufinfo_T	bi;
 
     vim_memset(&bi, 0, sizeof(bi));
@@ -1593,30 +1708,6 @@ u_write_undo(name, forceit, buf, hash)
     else
 	file_name = name;
 
-    /*
-     * Decide about the permission to use for the undo file.  If the buffer
-     * has a name use the permission of the original file.  Otherwise only
-     * allow the user to access the undo file.
-     */
-    perm = 0600;
-    if (buf->b_ffname != NULL)
-    {
-#ifdef UNIX
-	if (mch_stat((char *)buf->b_ffname, &st_old) >= 0)
-	{
-	    perm = st_old.st_mode;
-	    st_old_valid = TRUE;
-	}
-#else
-	perm = mch_getperm(buf->b_ffname);
-	if (perm < 0)
-	    perm = 0600;
-#endif
-    }
-
-    /* strip any s-bit and executable bit */
-    perm = perm & 0666;
-
     /* If the undo file already exists, verify that it actually is an undo
      * file, and delete it. */
     if (mch_getperm(file_name) >= 0)
@@ -1675,14 +1766,12 @@ u_write_undo(name, forceit, buf, hash)
 	goto theend;
     }
 
-    fd = mch_open((char *)file_name,
-			    O_CREAT|O_EXTRA|O_WRONLY|O_EXCL|O_NOFOLLOW, perm);
+    fd = u_create_cache_file(buf, file_name);
     if (fd < 0)
     {
 	EMSG2(_(e_not_open), file_name);
 	goto theend;
     }
-    (void)mch_setperm(file_name, perm);
     if (p_verbose > 0)
     {
 	verbose_enter();
@@ -1695,26 +1784,6 @@ u_write_undo(name, forceit, buf, hash)
     u_check(FALSE);
 #endif
 
-#ifdef UNIX
-    /*
-     * Try to set the group of the undo file same as the original file. If
-     * this fails, set the protection bits for the group same as the
-     * protection bits for others.
-     */
-    if (st_old_valid
-	    && mch_stat((char *)file_name, &st_new) >= 0
-	    && st_new.st_gid != st_old.st_gid
-# ifdef HAVE_FCHOWN  /* sequent-ptx lacks fchown() */
-	    && fchown(fd, (uid_t)-1, st_old.st_gid) != 0
-# endif
-       )
-	mch_setperm(file_name, (perm & 0707) | ((perm & 07) << 3));
-# if defined(HAVE_SELINUX) || defined(HAVE_SMACK)
-    if (buf->b_ffname != NULL)
-	mch_copy_sec(buf->b_ffname, file_name);
-# endif
-#endif
-
     fp = fdopen(fd, "w");
     if (fp == NULL)
     {
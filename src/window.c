@@ -4677,6 +4677,7 @@ win_alloc(after, hidden)
     new_wp->w_match_head = NULL;
     new_wp->w_next_match_id = 4;
 #endif
+    ga_init2(&new_wp->w_vcol_marks, (int)sizeof(vcolmark_T), 256);
     return new_wp;
 }
 
@@ -4747,6 +4748,7 @@ win_free(wp, tp)
     if (prevwin == wp)
 	prevwin = NULL;
     win_free_lsize(wp);
+    ga_clear(&wp->w_vcol_marks);
 
     for (i = 0; i < wp->w_tagstacklen; ++i)
 	vim_free(wp->w_tagstack[i].tagname);
@@ -4925,6 +4927,7 @@ win_free_lsize(wp)
     {
 	vim_free(wp->w_lines);
 	wp->w_lines = NULL;
+	linecache_free(wp);
     }
 }
 